@@ -13,13 +13,28 @@ CONFIG -= app_bundle
 
 TEMPLATE = app
 
-QMAKE_CXXFLAGS += -std=c++11 -Wall -Wextra -pedantic -g
+QMAKE_CXXFLAGS += -std=c++11 -Wall -Wextra -pedantic -g -pthread
+LIBS += -pthread -lrt
 
 include($$(MY_LIB_PATH)/QtOpenCL/QtOpenCL_libs.pri)
 
 HEADERS += \
-    input.h
+    input.h \
+    image_io.h \
+    box_filter.h \
+    trace.h \
+    validate.h \
+    parallel.h \
+    ipc.h \
+    server.h \
+    ocl_common.h
 SOURCES += main.cpp \
-    input.cpp
+    input.cpp \
+    image_io.cpp \
+    box_filter.cpp \
+    trace.cpp \
+    validate.cpp \
+    ipc.cpp \
+    server.cpp
 
 RESOURCES += resources.qrc
@@ -0,0 +1,898 @@
+/**
+ * Offline simulator of local and global memory access patterns of the corr_local_mem* kernels.
+ *
+ * The index expressions of cache[][], in[] and out[] from every variant are replayed
+ * on the host for a given tile and work-group geometry. All work-items of a work-group
+ * are executed one after another and their accesses are grouped into warp instructions
+ * (the same statement and the same iteration executed by the active work-items of a warp).
+ * For every instruction the number of local memory bank conflicts and the number of global
+ * memory transactions (distinct aligned segments) is computed.
+ *
+ * Usage: access_sim [TILE_W=32] [TILE_H=32] [WG_W=32] [WG_H=8] [PADDING=32]
+ *                   [W=1000] [H=1000] [WARP=32] [BANKS=32] [SEGMENT=128]
+ *                   [GROUPS_X=4] [GROUPS_Y=4] [VARIANT=name]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+
+
+namespace {
+
+/**************************************** KONFIGURACIA ****************************************/
+
+struct Config
+{
+  int tile_w = 32;
+  int tile_h = 32;
+  int wg_w = 32;
+  int wg_h = 8;
+  int padding = 32;      // alignment pouzity pre corr_local_mem_padding (v pocte floatov)
+  int w = 1000;          // velkost obrazku (bez halo)
+  int h = 1000;
+  int warp = 32;         // pocet work-itemov vo warpe
+  int banks = 32;        // pocet bankov lokalnej pamate (sirka banku 4 byty)
+  int segment = 128;     // velkost transakcie do globalnej pamate v bytoch
+  int groups_x = 4;      // pocet simulovanych work-group
+  int groups_y = 4;
+  std::string variant;   // ak je prazdny, simuluju sa vsetky varianty
+};
+
+
+/** Geometria jedneho spustenia kernelu (tak ako ju pocita main.cpp) */
+struct Launch
+{
+  int tile_w;
+  int tile_h;
+  int wg_w;
+  int wg_h;
+  int padding;
+  int in_row_pitch;
+  int out_row_pitch;
+  int grid_w;
+  int grid_h;
+};
+
+
+/**************************************** SIMULATOR ****************************************/
+
+class Sim
+{
+  public:
+    struct Totals
+    {
+      long local_instr = 0;      // pocet warp instrukcii do lokalnej pamate
+      long local_wavefronts = 0; // pocet serializovanych pristupov (1 = bez konfliktu)
+      int  local_max_degree = 0;
+      long global_instr = 0;
+      long global_tx = 0;        // pocet transakcii do globalnej pamate
+      long global_ideal_tx = 0;  // minimalny pocet transakcii pre dane mnozstvo dat
+      long store_instr = 0;
+      long store_tx = 0;
+      long store_ideal_tx = 0;
+      double imbalance_sum = 0.0;
+      double imbalance_max = 0.0;
+      long groups = 0;
+    };
+
+    struct WarpStats
+    {
+      long local_instr = 0;
+      long local_conflicts = 0;
+      long global_instr = 0;
+      long global_tx = 0;
+    };
+
+  public:
+    explicit Sim(const Config & cfg) : m_cfg(cfg) { }
+
+    void beginGroup(int wg_size)
+    {
+      m_warps.assign((wg_size + m_cfg.warp - 1) / m_cfg.warp, WarpInstrs());
+    }
+
+    void beginItem(int lid)
+    {
+      m_lid = lid;
+      m_occurrence.clear();
+    }
+
+    void global(int stmt, long idx, bool store = false) { record(stmt, idx, store ? Store : Load); }
+    void local(int stmt, long idx) { record(stmt, idx, Local); }
+
+    /** Vyhodnoti instrukcie zaznamenane pre aktualnu work-groupu */
+    std::vector<WarpStats> endGroup(void);
+
+    const Totals & totals(void) const { return m_totals; }
+
+  private:
+    enum Space { Local, Load, Store };
+
+    struct Instr
+    {
+      Space space;
+      std::vector<long> addrs;
+    };
+
+    typedef std::map<std::pair<int, int>, Instr> WarpInstrs;
+
+  private:
+    void record(int stmt, long idx, Space space)
+    {
+      int occ = m_occurrence[stmt]++;
+      Instr & instr = m_warps[m_lid / m_cfg.warp][std::make_pair(stmt, occ)];
+      instr.space = space;
+      instr.addrs.push_back(idx);
+    }
+
+    int bankConflictDegree(const std::vector<long> & addrs) const;
+    int transactions(const std::vector<long> & addrs) const;
+    int idealTransactions(const std::vector<long> & addrs) const;
+
+  private:
+    const Config & m_cfg;
+    std::vector<WarpInstrs> m_warps;
+    std::map<int, int> m_occurrence;
+    int m_lid = 0;
+    Totals m_totals;
+};
+
+
+int Sim::bankConflictDegree(const std::vector<long> & addrs) const
+{
+  // rovnake adresy sa broadcastuju, konflikt sposobuju iba rozne slova v tom istom banku
+  std::map<int, std::set<long>> banks;
+  for (long a : addrs) banks[int(a % m_cfg.banks)].insert(a);
+
+  int degree = 0;
+  for (const auto & b : banks) degree = std::max(degree, int(b.second.size()));
+
+  return degree;
+}
+
+
+int Sim::transactions(const std::vector<long> & addrs) const
+{
+  std::set<long> segments;
+  for (long a : addrs) segments.insert((a * long(sizeof(float))) / m_cfg.segment);
+  return int(segments.size());
+}
+
+
+int Sim::idealTransactions(const std::vector<long> & addrs) const
+{
+  // najmensi pocet segmentov (pri lubovolnom zarovnani), ktore pokryju vsetky slova,
+  // rozhadzane slova (napr. stlpec halo) tak stoja jednu transakciu kazde
+  std::set<long> words(addrs.begin(), addrs.end());
+  long words_per_segment = std::max(1L, long(m_cfg.segment) / long(sizeof(float)));
+
+  int n = 0;
+  long end = 0;
+  for (long a : words)
+  {
+    if ((n > 0) && (a < end)) continue;
+    end = a + words_per_segment;
+    ++n;
+  }
+
+  return n;
+}
+
+
+std::vector<Sim::WarpStats> Sim::endGroup(void)
+{
+  std::vector<WarpStats> stats(m_warps.size());
+  std::vector<double> cost(m_warps.size(), 0.0);
+
+  for (size_t w = 0; w < m_warps.size(); ++w)
+  {
+    for (const auto & it : m_warps[w])
+    {
+      const Instr & instr = it.second;
+
+      if (instr.space == Local)
+      {
+        int degree = bankConflictDegree(instr.addrs);
+        m_totals.local_instr++;
+        m_totals.local_wavefronts += degree;
+        m_totals.local_max_degree = std::max(m_totals.local_max_degree, degree);
+        stats[w].local_instr++;
+        stats[w].local_conflicts += degree - 1;
+        cost[w] += degree;
+      }
+      else
+      {
+        int tx = transactions(instr.addrs);
+        int ideal = idealTransactions(instr.addrs);
+        if (instr.space == Load)
+        {
+          m_totals.global_instr++;
+          m_totals.global_tx += tx;
+          m_totals.global_ideal_tx += ideal;
+        }
+        else
+        {
+          m_totals.store_instr++;
+          m_totals.store_tx += tx;
+          m_totals.store_ideal_tx += ideal;
+        }
+        stats[w].global_instr++;
+        stats[w].global_tx += tx;
+        cost[w] += tx;
+      }
+    }
+  }
+
+  // nerovnomernost zataze medzi warpmi = najvytazenejsi warp / priemerny warp
+  double sum = 0.0, max = 0.0;
+  for (double c : cost) { sum += c; max = std::max(max, c); }
+  double imbalance = (sum > 0.0) ? (max / (sum / cost.size())) : 1.0;
+
+  m_totals.imbalance_sum += imbalance;
+  m_totals.imbalance_max = std::max(m_totals.imbalance_max, imbalance);
+  m_totals.groups++;
+
+  m_warps.clear();
+
+  return stats;
+}
+
+
+/**************************************** VARIANTY KERNELOV ****************************************/
+
+/*
+ * Telo kazdeho kernelu je prepisane zo zodpovedajuceho .cl suboru, aktivne vetvy #if
+ * su zachovane. Kazdy pristup do cache[][] alebo in[] je nahradeny jednym z makier,
+ * ktore zaznamenaju pristup pod cislom riadku (statement id).
+ */
+
+#define IDX(x, y, size) ((x) + (size) * (y))
+
+#define LOAD(cache_idx, in_idx) \
+  do { \
+    sim.global(2 * __LINE__, (in_idx)); \
+    sim.local(2 * __LINE__ + 1, (cache_idx)); \
+  } while (0)
+
+#define READ(cache_idx) sim.local(2 * __LINE__, (cache_idx))
+#define STORE(out_idx) sim.global(2 * __LINE__, (out_idx), true)
+
+#define WARP_ID(lid) ((lid) >> 5)
+#define IS_WARP0(lid) ((WARP_ID(lid)) == 0)
+#define IS_WARP1(lid) ((WARP_ID(lid)) == 1)
+#define IS_WARP2(lid) ((WARP_ID(lid)) == 2)
+
+#define KERNEL_PROLOGUE(cache_pitch) \
+  const int TILE_W = l.tile_w; \
+  const int TILE_H = l.tile_h; \
+  const int WG_W = l.wg_w; \
+  const int WG_H = l.wg_h; \
+  const int PADDING = l.padding; \
+  const int in_row_pitch = l.in_row_pitch; \
+  const int out_row_pitch = l.out_row_pitch; \
+  const int CACHE_PITCH = (cache_pitch); \
+  int lid = li + lj * WG_W; \
+  (void) TILE_W; (void) TILE_H; (void) WG_H; (void) PADDING; (void) lid; (void) CACHE_PITCH
+
+#define CACHE(r, c) ((r) * CACHE_PITCH + (c))
+
+typedef void (* TKernelFunc)(Sim & sim, const Launch & l, int gx, int gy, int li, int lj);
+
+
+void corrLocalMem(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * TILE_H;
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    LOAD(CACHE(lj + 1 + k, li + 1), (gi_0 + li + 1) + (gj_0 + lj + 1 + k) * in_row_pitch);
+  }
+
+  if (lid < WG_W) LOAD(CACHE(0, li + 1), (gi_0 + li + 1) + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(TILE_H + 1, li + 1), (gi_0 + li + 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 3))) LOAD(CACHE(li + 1, 0), gi_0 + (gj_0 + li + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 4))) LOAD(CACHE(li + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + li + 1) * in_row_pitch);
+
+  if (lid < WG_W) LOAD(CACHE(0, 0), gi_0 + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(TILE_H + 1, 0), gi_0 + (gj_0 + TILE_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 3))) LOAD(CACHE(0, TILE_W + 1), (gi_0 + TILE_W + 1) + gj_0 * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 4))) LOAD(CACHE(TILE_H + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    for (int j = -1; j <= 1; ++j)
+      for (int i = -1; i <= 1; ++i)
+        READ(CACHE(lj + 1 + k + j, li + 1 + i));
+
+    STORE(IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch));
+  }
+}
+
+
+void corrLocalMemV2(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * WG_H;
+
+  LOAD(CACHE(lj + 1, li + 1), (gi_0 + li + 1) + (gj_0 + lj + 1) * in_row_pitch);
+
+  if (lid < WG_W) LOAD(CACHE(0, li + 1), (gi_0 + li + 1) + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(WG_H + 1, li + 1), (gi_0 + li + 1) + (gj_0 + WG_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 2 + WG_H))) LOAD(CACHE(li + 1, 0), gi_0 + (gj_0 + li + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 3 + WG_H))) LOAD(CACHE(li + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + li + 1) * in_row_pitch);
+
+  if (lid < WG_W) LOAD(CACHE(0, 0), gi_0 + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(WG_H + 1, 0), gi_0 + (gj_0 + WG_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 3))) LOAD(CACHE(0, TILE_W + 1), (gi_0 + TILE_W + 1) + gj_0 * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 4))) LOAD(CACHE(WG_H + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + WG_H + 1) * in_row_pitch);
+
+  for (int j = -1; j <= 1; ++j)
+    for (int i = -1; i <= 1; ++i)
+      READ(CACHE(lj + 1 + j, li + 1 + i));
+
+  STORE(IDX(gi_0 + li, gj_0 + lj, out_row_pitch));
+}
+
+
+void corrLocalMemCorners(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * TILE_H;
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    LOAD(CACHE(lj + 1 + k, li + 1), (gi_0 + li + 1) + (gj_0 + lj + 1 + k) * in_row_pitch);
+  }
+
+  if (lid < WG_W) LOAD(CACHE(0, li + 1), (gi_0 + li + 1) + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(TILE_H + 1, li + 1), (gi_0 + li + 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 3))) LOAD(CACHE(li + 1, 0), gi_0 + (gj_0 + li + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 4))) LOAD(CACHE(li + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + li + 1) * in_row_pitch);
+
+  if (lid == 0)
+  {
+    LOAD(CACHE(0, 0), gi_0 + gj_0 * in_row_pitch);
+    LOAD(CACHE(0, TILE_W + 1), (gi_0 + TILE_W + 1) + gj_0 * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, 0), gi_0 + (gj_0 + TILE_H + 1) * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  }
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    for (int j = -1; j <= 1; ++j)
+      for (int i = -1; i <= 1; ++i)
+        READ(CACHE(lj + 1 + k + j, li + 1 + i));
+
+    STORE(IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch));
+  }
+}
+
+
+void corrLocalMemRightBorder(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * TILE_H;
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    LOAD(CACHE(lj + k, li), (gi_0 + li) + (gj_0 + lj + k) * in_row_pitch);
+  }
+
+  if (lid < WG_W) LOAD(CACHE(TILE_H, li), (gi_0 + li) + (gj_0 + TILE_H) * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(TILE_H + 1, li), (gi_0 + li) + (gj_0 + TILE_H + 1) * in_row_pitch);
+
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 3)))
+  {
+    LOAD(CACHE(li, TILE_W),     (gi_0 + TILE_W    ) + (gj_0 + li) * in_row_pitch);
+    LOAD(CACHE(li, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + li) * in_row_pitch);
+  }
+
+  if (lid == 0)
+  {
+    LOAD(CACHE(TILE_H,     TILE_W),     (gi_0 + TILE_W)     + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(CACHE(TILE_H,     TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, TILE_W),     (gi_0 + TILE_W)     + (gj_0 + TILE_H + 1) * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  }
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    for (int j = -1; j <= 1; ++j)
+      for (int i = -1; i <= 1; ++i)
+        READ(CACHE(lj + 1 + k + j, li + 1 + i));
+
+    STORE(IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch));
+  }
+}
+
+
+void corrLocalMemRightBorder2(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * TILE_H;
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    LOAD(CACHE(lj + k, li), (gi_0 + li) + (gj_0 + lj + k) * in_row_pitch);
+  }
+
+  if (IS_WARP0(lid)) LOAD(CACHE(TILE_H, li), (gi_0 + li) + (gj_0 + TILE_H) * in_row_pitch);
+  if (IS_WARP1(lid)) LOAD(CACHE(TILE_H + 1, li), (gi_0 + li) + (gj_0 + TILE_H + 1) * in_row_pitch);
+
+  if (IS_WARP2(lid))
+  {
+    LOAD(CACHE(li, TILE_W),     (gi_0 + TILE_W    ) + (gj_0 + li) * in_row_pitch);
+    LOAD(CACHE(li, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + li) * in_row_pitch);
+  }
+
+  if (lid == 0)
+  {
+    LOAD(CACHE(TILE_H,     TILE_W),     (gi_0 + TILE_W)     + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(CACHE(TILE_H,     TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, TILE_W),     (gi_0 + TILE_W)     + (gj_0 + TILE_H + 1) * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  }
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    for (int j = -1; j <= 1; ++j)
+      for (int i = -1; i <= 1; ++i)
+        READ(CACHE(lj + 1 + k + j, li + 1 + i));
+
+    STORE(IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch));
+  }
+}
+
+
+void corrLocalMemRowsJoint(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * TILE_H;
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    LOAD(CACHE(lj + k, li), (gi_0 + li) + (gj_0 + lj + k) * in_row_pitch);
+  }
+
+  if (IS_WARP0(lid))
+  {
+    LOAD(CACHE(TILE_H,     li), (gi_0 + li) + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, li), (gi_0 + li) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  }
+
+  if (IS_WARP1(lid))
+  {
+    LOAD(CACHE(li, TILE_W),     (gi_0 + TILE_W    ) + (gj_0 + li) * in_row_pitch);
+    LOAD(CACHE(li, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + li) * in_row_pitch);
+  }
+
+  if (lid == 0)
+  {
+    LOAD(CACHE(TILE_H,     TILE_W),     (gi_0 + TILE_W)     + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(CACHE(TILE_H,     TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, TILE_W),     (gi_0 + TILE_W)     + (gj_0 + TILE_H + 1) * in_row_pitch);
+    LOAD(CACHE(TILE_H + 1, TILE_W + 1), (gi_0 + TILE_W + 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  }
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    for (int j = -1; j <= 1; ++j)
+      for (int i = -1; i <= 1; ++i)
+        READ(CACHE(lj + 1 + k + j, li + 1 + i));
+
+    STORE(IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch));
+  }
+}
+
+
+void corrLocalMemIndexing(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+  const int TILE_STRIDE = CACHE_PITCH;
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * TILE_H;
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    LOAD(li + (lj + k) * TILE_STRIDE, (gi_0 + li) + (gj_0 + lj + k) * in_row_pitch);
+  }
+
+  if (IS_WARP0(lid)) LOAD(li + TILE_H * TILE_STRIDE, (gi_0 + li) + (gj_0 + TILE_H) * in_row_pitch);
+  if (IS_WARP1(lid)) LOAD(li + (TILE_H + 1) * TILE_STRIDE, (gi_0 + li) + (gj_0 + TILE_H + 1) * in_row_pitch);
+
+  if (IS_WARP2(lid))
+  {
+    LOAD(TILE_W +     li * TILE_STRIDE, (gi_0 + TILE_W    ) + (gj_0 + li) * in_row_pitch);
+    LOAD(TILE_W + 1 + li * TILE_STRIDE, (gi_0 + TILE_W + 1) + (gj_0 + li) * in_row_pitch);
+  }
+
+  if (lid == 0)
+  {
+    LOAD(TILE_W +     TILE_H * TILE_STRIDE,       (gi_0 + TILE_W)     + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(TILE_W + 1 + TILE_H * TILE_STRIDE,       (gi_0 + TILE_W + 1) + (gj_0 + TILE_H)     * in_row_pitch);
+    LOAD(TILE_W     + (TILE_H + 1) * TILE_STRIDE, (gi_0 + TILE_W)     + (gj_0 + TILE_H + 1) * in_row_pitch);
+    LOAD(TILE_W + 1 + (TILE_H + 1) * TILE_STRIDE, (gi_0 + TILE_W + 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  }
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    for (int j = -1; j <= 1; ++j)
+      for (int i = -1; i <= 1; ++i)
+        READ(li + 1 + i + (lj + 1 + k + j) * TILE_STRIDE);
+
+    STORE(IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch));
+  }
+}
+
+
+void corrLocalMemPadding(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * TILE_H;
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    LOAD(CACHE(lj + 1 + k, li + 1), (gi_0 + li + PADDING) + (gj_0 + lj + 1 + k) * in_row_pitch);
+  }
+
+  if (lid < WG_W) LOAD(CACHE(0, li + 1), (gi_0 + li + PADDING) + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(TILE_H + 1, li + 1), (gi_0 + li + PADDING) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 3))) LOAD(CACHE(li + 1, 0), (gi_0 + PADDING - 1) + (gj_0 + li + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 4))) LOAD(CACHE(li + 1, TILE_W + 1), (gi_0 + PADDING + TILE_W) + (gj_0 + li + 1) * in_row_pitch);
+
+  if (lid < WG_W) LOAD(CACHE(0, 0), (gi_0 + PADDING - 1) + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(TILE_H + 1, 0), (gi_0 + PADDING - 1) + (gj_0 + TILE_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 3))) LOAD(CACHE(0, TILE_W + 1), (gi_0 + PADDING + TILE_W) + gj_0 * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 4))) LOAD(CACHE(TILE_H + 1, TILE_W + 1), (gi_0 + PADDING + TILE_W) + (gj_0 + TILE_H + 1) * in_row_pitch);
+
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    for (int j = -1; j <= 1; ++j)
+      for (int i = -1; i <= 1; ++i)
+        READ(CACHE(lj + 1 + k + j, li + 1 + i));
+
+    STORE(IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch));
+  }
+}
+
+
+void corrLocalMemPaddingV2(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  KERNEL_PROLOGUE(l.tile_w + 2);
+
+  int gi_0 = gx * TILE_W;
+  int gj_0 = gy * WG_H;
+
+  LOAD(CACHE(lj + 1, li + 1), (gi_0 + li + PADDING) + (gj_0 + lj + 1) * in_row_pitch);
+
+  if (lid < WG_W) LOAD(CACHE(0, li + 1), (gi_0 + li + PADDING) + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(WG_H + 1, li + 1), (gi_0 + li + PADDING) + (gj_0 + WG_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 2 + WG_H))) LOAD(CACHE(li + 1, 0), (gi_0 + PADDING - 1) + (gj_0 + li + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 3 + WG_H))) LOAD(CACHE(li + 1, TILE_W + 1), (gi_0 + PADDING + TILE_W) + (gj_0 + li + 1) * in_row_pitch);
+
+  if (lid < WG_W) LOAD(CACHE(0, 0), (gi_0 + PADDING - 1) + gj_0 * in_row_pitch);
+  if ((lid >= WG_W) && (lid < (WG_W * 2))) LOAD(CACHE(WG_H + 1, 0), (gi_0 + PADDING - 1) + (gj_0 + WG_H + 1) * in_row_pitch);
+  if ((lid >= (WG_W * 2)) && (lid < (WG_W * 3))) LOAD(CACHE(0, TILE_W + 1), (gi_0 + PADDING + TILE_W) + gj_0 * in_row_pitch);
+  if ((lid >= (WG_W * 3)) && (lid < (WG_W * 4))) LOAD(CACHE(WG_H + 1, TILE_W + 1), (gi_0 + PADDING + TILE_W) + (gj_0 + WG_H + 1) * in_row_pitch);
+
+  for (int j = -1; j <= 1; ++j)
+    for (int i = -1; i <= 1; ++i)
+      READ(CACHE(lj + 1 + j, li + 1 + i));
+
+  STORE(IDX(gi_0 + li, gj_0 + lj, out_row_pitch));
+}
+
+
+void corrLocalMemInnerTile(Sim & sim, const Launch & l, int gx, int gy, int li, int lj)
+{
+  // IN_TILE = work-group, OUT_TILE = IN_TILE - 2
+  KERNEL_PROLOGUE(l.wg_w);
+  const int OUT_TILE_W = l.tile_w;
+  const int OUT_TILE_H = l.tile_h;
+
+  int gi = gx * OUT_TILE_W + li;
+  int gj = gy * OUT_TILE_H + lj;
+  LOAD(CACHE(lj, li), IDX(gi, gj, in_row_pitch));
+
+  if ((li < OUT_TILE_W) && (lj < OUT_TILE_H))
+  {
+    for (int j = -1; j <= 1; ++j)
+      for (int i = -1; i <= 1; ++i)
+        READ(CACHE(lj + 1 + j, li + 1 + i));
+
+    STORE(IDX(gi, gj, out_row_pitch));
+  }
+}
+
+
+/**************************************** GEOMETRIA SPUSTENIA ****************************************/
+
+enum Layout { Plain, PlainV2, Padded, PaddedV2, InnerTile };
+
+struct Variant
+{
+  const char *name;
+  TKernelFunc func;
+  Layout layout;
+};
+
+const Variant variants[] = {
+  { "corr_local_mem",                corrLocalMem,             Plain     },
+  { "corr_local_mem_v2",             corrLocalMemV2,           PlainV2   },
+  { "corr_local_mem_corners",        corrLocalMemCorners,      Plain     },
+  { "corr_local_mem_right_border",   corrLocalMemRightBorder,  Plain     },
+  { "corr_local_mem_right_border_2", corrLocalMemRightBorder2, Plain     },
+  { "corr_local_mem_rows_joint",     corrLocalMemRowsJoint,    Plain     },
+  { "corr_local_mem_indexing",       corrLocalMemIndexing,     Plain     },
+  { "corr_local_mem_padding",        corrLocalMemPadding,      Padded    },
+  { "corr_local_mem_padding_v2",     corrLocalMemPaddingV2,    PaddedV2  },
+  { "corr_local_mem_inner_tile",     corrLocalMemInnerTile,    InnerTile }
+};
+
+
+/**
+ * Checks that the work-group covers the tile of the variant the same way the kernel expects.
+ * Geometries for which the kernel would index outside of cache[][] are rejected,
+ * the ones that only leave part of the halo unloaded produce a warning.
+ */
+bool checkGeometry(const Launch & l, Layout layout)
+{
+  if (layout == InnerTile) return true;   // vstupny tile ma vzdy rozmery work-groupy
+
+  bool ok = true;
+
+  // kazdy work-item nacitava jeden stlpec tilu
+  if (l.wg_w > l.tile_w)
+  {
+    std::cout << "WG_W=" << l.wg_w << " is larger than TILE_W=" << l.tile_w << ", the kernel overruns the tile" << std::endl;
+    ok = false;
+  }
+  else if (l.wg_w < l.tile_w)
+  {
+    std::cout << "Warning: WG_W=" << l.wg_w << " is smaller than TILE_W=" << l.tile_w << ", part of the tile is not loaded" << std::endl;
+  }
+
+  if ((layout == PlainV2) || (layout == PaddedV2))
+  {
+    // lavy a pravy okraj nacita WG_H work-itemov z jedneho riadku work-groupy
+    if (l.wg_h > l.wg_w)
+    {
+      std::cout << "Warning: WG_H=" << l.wg_h << " is larger than WG_W=" << l.wg_w << ", part of the left and right halo is not loaded" << std::endl;
+    }
+    return ok;
+  }
+
+  // tile sa spracuva po krokoch vysky WG_H
+  if ((l.tile_h % l.wg_h) != 0)
+  {
+    std::cout << "TILE_H=" << l.tile_h << " is not a multiple of WG_H=" << l.wg_h << ", the last step overruns the tile" << std::endl;
+    ok = false;
+  }
+
+  // lavy a pravy okraj nacita jeden riadok work-groupy, t.j. WG_W riadkov tilu
+  if (l.tile_h < l.wg_w)
+  {
+    std::cout << "TILE_H=" << l.tile_h << " is smaller than WG_W=" << l.wg_w << ", the left and right halo overrun the tile" << std::endl;
+    ok = false;
+  }
+  else if (l.tile_h > l.wg_w)
+  {
+    std::cout << "Warning: TILE_H=" << l.tile_h << " is larger than WG_W=" << l.wg_w << ", part of the left and right halo is not loaded" << std::endl;
+  }
+
+  return ok;
+}
+
+
+/** Vypocita velkosti bufferov rovnako ako prislusna funkcia corrOCL* v main.cpp */
+Launch makeLaunch(const Config & cfg, Layout layout)
+{
+  Launch l;
+  l.tile_w = cfg.tile_w;
+  l.tile_h = ((layout == PlainV2) || (layout == PaddedV2)) ? cfg.wg_h : cfg.tile_h;
+  l.wg_w = cfg.wg_w;
+  l.wg_h = cfg.wg_h;
+  l.padding = cfg.padding;
+
+  if (layout == InnerTile)
+  {
+    l.tile_w = cfg.wg_w - 2;
+    l.tile_h = cfg.wg_h - 2;
+  }
+
+  l.grid_w = (cfg.w + l.tile_w - 1) / l.tile_w;
+  l.grid_h = (cfg.h + l.tile_h - 1) / l.tile_h;
+
+  int in_w  = l.grid_w * l.tile_w;
+  int out_w = l.grid_w * l.tile_w;
+
+  if ((layout == Padded) || (layout == PaddedV2))
+  {
+    int alignment = cfg.padding;
+    int padding_in = (in_w + 1) % alignment;
+    if (padding_in != 0) padding_in = alignment - padding_in;
+    int padding_out = out_w % alignment;
+    if (padding_out != 0) padding_out = alignment - padding_out;
+
+    in_w = alignment + in_w + 1 + padding_in;
+    out_w = out_w + padding_out;
+  }
+  else
+  {
+    in_w += 2;
+  }
+
+  l.in_row_pitch = in_w;
+  l.out_row_pitch = out_w;
+
+  return l;
+}
+
+
+void simulate(const Config & cfg, const Variant & v)
+{
+  Launch l = makeLaunch(cfg, v.layout);
+  Sim sim(cfg);
+
+  int groups_x = std::min(cfg.groups_x, l.grid_w);
+  int groups_y = std::min(cfg.groups_y, l.grid_h);
+
+  std::cout << "==========================================================================" << std::endl;
+  std::cout << "*** " << v.name << " ***" << std::endl;
+  std::cout << "tile_width=" << l.tile_w << ", tile_height=" << l.tile_h
+            << ", block_width=" << l.wg_w << ", block_height=" << l.wg_h
+            << ", in_row_pitch=" << l.in_row_pitch << ", out_row_pitch=" << l.out_row_pitch
+            << ", simulated groups=" << groups_x << "x" << groups_y
+            << std::endl;
+
+  if (!checkGeometry(l, v.layout))
+  {
+    std::cout << "Skipped, the geometry does not fit the kernel" << std::endl;
+    return;
+  }
+
+  for (int gy = 0; gy < groups_y; ++gy)
+  {
+    for (int gx = 0; gx < groups_x; ++gx)
+    {
+      sim.beginGroup(l.wg_w * l.wg_h);
+
+      for (int lj = 0; lj < l.wg_h; ++lj)
+      {
+        for (int li = 0; li < l.wg_w; ++li)
+        {
+          sim.beginItem(li + lj * l.wg_w);
+          v.func(sim, l, gx, gy, li, lj);
+        }
+      }
+
+      std::vector<Sim::WarpStats> stats = sim.endGroup();
+
+      // rozpis po warpoch pre prvu work-groupu
+      if ((gx == 0) && (gy == 0))
+      {
+        std::cout << std::setw(6) << "warp" << std::setw(14) << "local instr" << std::setw(16) << "bank conflicts"
+                  << std::setw(15) << "global instr" << std::setw(14) << "global tx" << std::endl;
+        for (size_t w = 0; w < stats.size(); ++w)
+        {
+          std::cout << std::setw(6) << w << std::setw(14) << stats[w].local_instr << std::setw(16) << stats[w].local_conflicts
+                    << std::setw(15) << stats[w].global_instr << std::setw(14) << stats[w].global_tx << std::endl;
+        }
+      }
+    }
+  }
+
+  const Sim::Totals & t = sim.totals();
+  double n = double(t.groups);
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "Local memory: " << (t.local_instr / n) << " warp instructions per group, "
+            << ((t.local_wavefronts - t.local_instr) / n) << " bank conflicts per group, "
+            << "max conflict degree " << t.local_max_degree << std::endl;
+  std::cout << "Global loads: " << (t.global_instr / n) << " warp instructions per group, "
+            << (t.global_tx / n) << " transactions per group (ideal " << (t.global_ideal_tx / n) << ")" << std::endl;
+  std::cout << "Global stores: " << (t.store_instr / n) << " warp instructions per group, "
+            << (t.store_tx / n) << " transactions per group (ideal " << (t.store_ideal_tx / n) << ")" << std::endl;
+  std::cout << "Load imbalance across warps (max/avg): " << (t.imbalance_sum / n) << " average, "
+            << t.imbalance_max << " worst" << std::endl;
+  std::cout.unsetf(std::ios_base::floatfield);
+}
+
+
+bool parseArgs(int argc, char *argv[], Config & cfg)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const char *eq = std::strchr(argv[i], '=');
+    if (eq == nullptr)
+    {
+      std::cerr << "Invalid argument (expected NAME=value): " << argv[i] << std::endl;
+      return false;
+    }
+
+    std::string key(argv[i], eq - argv[i]);
+    const char *val = eq + 1;
+
+    if (key == "TILE_W") cfg.tile_w = std::atoi(val);
+    else if (key == "TILE_H") cfg.tile_h = std::atoi(val);
+    else if (key == "WG_W") cfg.wg_w = std::atoi(val);
+    else if (key == "WG_H") cfg.wg_h = std::atoi(val);
+    else if (key == "PADDING") cfg.padding = std::atoi(val);
+    else if (key == "W") cfg.w = std::atoi(val);
+    else if (key == "H") cfg.h = std::atoi(val);
+    else if (key == "WARP") cfg.warp = std::atoi(val);
+    else if (key == "BANKS") cfg.banks = std::atoi(val);
+    else if (key == "SEGMENT") cfg.segment = std::atoi(val);
+    else if (key == "GROUPS_X") cfg.groups_x = std::atoi(val);
+    else if (key == "GROUPS_Y") cfg.groups_y = std::atoi(val);
+    else if (key == "VARIANT") cfg.variant = val;
+    else
+    {
+      std::cerr << "Unknown parameter: " << key << std::endl;
+      return false;
+    }
+  }
+
+  if ((cfg.tile_w <= 0) || (cfg.tile_h <= 0) || (cfg.wg_w <= 2) || (cfg.wg_h <= 2) ||
+      (cfg.padding <= 0) || (cfg.w <= 0) || (cfg.h <= 0) || (cfg.warp <= 0) ||
+      (cfg.banks <= 0) || (cfg.segment <= 0) || (cfg.groups_x <= 0) || (cfg.groups_y <= 0))
+  {
+    std::cerr << "All parameters have to be positive (WG_W and WG_H larger than 2)" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+}
+
+
+/**************************************** MAIN ****************************************/
+
+int main(int argc, char *argv[])
+{
+  Config cfg;
+  if (!parseArgs(argc, argv, cfg)) return 1;
+
+  bool found = false;
+  for (const Variant & v : variants)
+  {
+    if (cfg.variant.empty() || (cfg.variant == v.name))
+    {
+      simulate(cfg, v);
+      found = true;
+    }
+  }
+
+  if (!found)
+  {
+    std::cerr << "Unknown variant: " << cfg.variant << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# Offline simulator of local/global memory access patterns
+# of the corr_local_mem* kernels (does not need OpenCL)
+#
+#-------------------------------------------------
+
+QT -= core gui
+
+TARGET = access_sim
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += -std=c++11 -Wall -Wextra -pedantic -g
+
+SOURCES += access_sim.cpp
@@ -0,0 +1,105 @@
+#include "box_filter.h"
+#include "parallel.h"
+
+#include <vector>
+
+#define IDX(x, y, size) ((x) + (size) * (y))
+
+
+
+namespace box_filter {
+
+bool isConstMask(const float *mask, int mask_w, float & value)
+{
+  value = mask[0];
+
+  for (int i = 1; i < mask_w * mask_w; ++i)
+  {
+    if (mask[i] != value) return false;
+  }
+
+  return true;
+}
+
+
+void corrBoxCPU(const float *in, float value, float *out, int w, int h, int r, int n_threads)
+{
+  const int in_row_pitch = w + 2 * r;
+  const int rows = h + 2 * r;
+
+  // suma cez okno 2 * r + 1 v smere riadkov (vysledok ma o 2 * r viac riadkov ako vystup),
+  // kvoli presnosti sa bezne sumy pocitaju v double, medzivysledok sa ulozi ako float
+  std::vector<float> tmp(size_t(w) * rows);
+
+  parallelFor(rows, n_threads, [&](int, int j0, int j1) {
+    for (int j = j0; j < j1; ++j)
+    {
+      const float *src = in + size_t(j) * in_row_pitch;
+      float *dst = tmp.data() + size_t(j) * w;
+
+      double sum = 0.0;
+      for (int i = 0; i < 2 * r; ++i) sum += src[i];
+
+      for (int i = 0; i < w; ++i)
+      {
+        sum += src[i + 2 * r];
+        dst[i] = float(sum);
+        sum -= src[i];
+      }
+    }
+  });
+
+  // suma v smere stlpcov, kazde vlakno posuva okno cez svoj pas riadkov
+  parallelFor(h, n_threads, [&](int, int j0, int j1) {
+    std::vector<double> sum(w, 0.0);
+
+    for (int j = j0; j < j0 + 2 * r; ++j)
+    {
+      const float *src = tmp.data() + size_t(j) * w;
+      for (int i = 0; i < w; ++i) sum[i] += src[i];
+    }
+
+    for (int j = j0; j < j1; ++j)
+    {
+      const float *add = tmp.data() + size_t(j + 2 * r) * w;
+      const float *sub = tmp.data() + size_t(j) * w;
+      float *dst = out + size_t(j) * w;
+
+      for (int i = 0; i < w; ++i)
+      {
+        sum[i] += add[i];
+        dst[i] = float(sum[i] * value);
+        sum[i] -= sub[i];
+      }
+    }
+  });
+}
+
+
+void corrReferenceRadius(const float *in, const float *mask, float *out, int w, int h, int r, int n_threads)
+{
+  const int in_row_pitch = w + 2 * r;
+  const int mask_w = 2 * r + 1;
+
+  parallelFor(h, n_threads, [&](int, int j0, int j1) {
+    for (int j = j0 + r; j < j1 + r; ++j)
+    {
+      for (int i = r; i < w + r; ++i)
+      {
+        float sum = 0.0f;
+
+        for (int jj = -r; jj <= r; ++jj)
+        {
+          for (int ii = -r; ii <= r; ++ii)
+          {
+            sum += in[IDX(i + ii, j + jj, in_row_pitch)] * mask[IDX(ii + r, jj + r, mask_w)];
+          }
+        }
+
+        out[IDX(i - r, j - r, w)] = sum;
+      }
+    }
+  });
+}
+
+} // End of box_filter namespace
@@ -0,0 +1,28 @@
+#ifndef BOX_FILTER_H
+#define BOX_FILTER_H
+
+namespace box_filter {
+
+/**
+ * Returns true if all coefficients of the mask_w x mask_w mask are equal,
+ * in which case the correlation is a box filter scaled by value.
+ */
+bool isConstMask(const float *mask, int mask_w, float & value);
+
+/**
+ * Box filter of radius r computed with running sums along rows and then along columns,
+ * so the cost per pixel does not depend on the radius.
+ * in has a border of r pixels on each side (row pitch w + 2 * r), out is w x h.
+ * If n_threads is 0, all hardware threads are used.
+ */
+void corrBoxCPU(const float *in, float value, float *out, int w, int h, int r, int n_threads = 0);
+
+/**
+ * Straightforward correlation with a (2 * r + 1) x (2 * r + 1) mask, used for validation.
+ * The rows of the output are split among n_threads threads (0 = all hardware threads).
+ */
+void corrReferenceRadius(const float *in, const float *mask, float *out, int w, int h, int r, int n_threads = 0);
+
+} // End of box_filter namespace
+
+#endif // BOX_FILTER_H
@@ -0,0 +1,45 @@
+#define IDX(x, y, size) ((x) + (size) * (y))
+
+
+/**********************************************
+ * Converts raw pixels uploaded directly from the input file
+ * (PIXEL_T = uchar, ushort or float of PIXEL_SIZE bytes) into the float input buffer
+ * of the correlation kernels. Rows y_0 .. y_0 + h - 1 are converted into the same rows
+ * of the output, shifted one pixel to the right, so that the left halo stays untouched.
+ * SWAP_BYTES converts big endian data (16 bit PGM, Motorola TIFF).
+ */
+
+//#define PIXEL_T ushort
+//#define PIXEL_SIZE 2
+//#define SWAP_BYTES 1
+
+#ifndef SWAP_BYTES
+#define SWAP_BYTES 0
+#endif
+
+
+__kernel void convert(__global const PIXEL_T *src,
+                      __global       float   *dst,
+                      const int src_row_pitch,
+                      const int dst_row_pitch,
+                      const int w,
+                      const int h,
+                      const int y_0)
+{
+  int i = get_global_id(0);
+  int j = get_global_id(1);
+
+  if ((i >= w) || (j >= h)) return;
+
+  j += y_0;
+
+  PIXEL_T val = src[IDX(i, j, src_row_pitch)];
+
+#if SWAP_BYTES && (PIXEL_SIZE == 2)
+  val = (ushort) ((val << 8) | (val >> 8));
+#elif SWAP_BYTES && (PIXEL_SIZE == 4)
+  val = as_float(as_uchar4(val).s3210);
+#endif
+
+  dst[IDX(i + 1, j, dst_row_pitch)] = convert_float(val);
+}
@@ -0,0 +1,80 @@
+#define IDX(x, y, size) ((x) + (size) * (y))
+
+//#pragma OPENCL EXTENSION cl_amd_printf : enable
+
+
+/**********************************************
+ * Box filter (correlation with a constant mask) of radius RADIUS computed
+ * in two separable passes with running sums.
+ * Every work-item processes a segment of SEG pixels: it sums the first window
+ * and then slides it along the segment by adding the entering and subtracting
+ * the leaving pixel. Short segments keep the rounding error of the running sum
+ * bounded, while the initial sum of 2 * RADIUS pixels is amortized over SEG pixels,
+ * i.e. the work per pixel is (SEG + 2 * RADIUS) / SEG. The host scales SEG
+ * with the radius (SEG >= 8 * RADIUS), so it stays below 1.25 for any radius.
+ */
+
+//#define RADIUS 1
+//#define SEG 32
+
+#define WINDOW (2 * (RADIUS) + 1)
+
+
+/**
+ * Horizontal pass, every work-item processes SEG pixels of one row.
+ * tmp has w columns and h + 2 * RADIUS rows.
+ */
+__kernel void box_rows(__global const float *in,
+                       __global       float *tmp,
+                       const int in_row_pitch,
+                       const int w,
+                       const int rows)
+{
+  int i0 = get_global_id(0) * SEG;
+  int j  = get_global_id(1);
+
+  if ((i0 >= w) || (j >= rows)) return;
+
+  __global const float *src = in + j * in_row_pitch;
+  __global       float *dst = tmp + j * w;
+
+  float sum = 0.0f;
+  for (int k = 0; k < WINDOW - 1; ++k) sum += src[i0 + k];
+
+  int i1 = min(i0 + SEG, w);
+  for (int i = i0; i < i1; ++i)
+  {
+    sum += src[i + WINDOW - 1];
+    dst[i] = sum;
+    sum -= src[i];
+  }
+}
+
+
+/**
+ * Vertical pass, every work-item processes SEG pixels of one column,
+ * neighbouring work-items read neighbouring columns (coalesced access).
+ */
+__kernel void box_cols(__global const float *tmp,
+                       __global       float *out,
+                       const float value,
+                       const int w,
+                       const int h,
+                       const int out_row_pitch)
+{
+  int i  = get_global_id(0);
+  int j0 = get_global_id(1) * SEG;
+
+  if ((i >= w) || (j0 >= h)) return;
+
+  float sum = 0.0f;
+  for (int k = 0; k < WINDOW - 1; ++k) sum += tmp[IDX(i, j0 + k, w)];
+
+  int j1 = min(j0 + SEG, h);
+  for (int j = j0; j < j1; ++j)
+  {
+    sum += tmp[IDX(i, j + WINDOW - 1, w)];
+    out[IDX(i, j, out_row_pitch)] = sum * value;
+    sum -= tmp[IDX(i, j, w)];
+  }
+}
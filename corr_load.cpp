@@ -0,0 +1,270 @@
+/**
+ * Load generator for the correlation server (OpenCL_local_memory --server).
+ *
+ * Starts CLIENTS threads, every one with its own connection and INFLIGHT shared memory
+ * frames, so up to INFLIGHT jobs of each client are pipelined. Every client submits JOBS
+ * jobs with the same random input, checks every output against the C++ reference
+ * and measures the round trip latency. At the end the client side latency percentiles
+ * are printed together with the queue, run and kernel times reported by the server.
+ *
+ * Usage: corr_load [SOCKET=/tmp/corr_server.sock] [CLIENTS=4] [JOBS=100] [INFLIGHT=2]
+ *                  [W=1000] [H=1000] [PROGRAM=corr_local_mem] [SEED=24301]
+ */
+
+#include "ipc.h"
+#include "input.h"
+#include "box_filter.h"
+#include "validate.h"
+#include "parallel.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+
+
+namespace {
+
+struct Config
+{
+  std::string socket = ipc::DEFAULT_SOCKET;
+  int clients = 4;
+  int jobs = 100;
+  int inflight = 2;
+  int w = 1000;
+  int h = 1000;
+  std::string program = "corr_local_mem";
+  uint64_t seed = input::DEFAULT_SEED;
+};
+
+
+/** Results of one client */
+struct ClientStats
+{
+  std::vector<double> latency_ms;       // round trip merany klientom
+  double queue_ms = 0.0;                // sucty casov hlasenych serverom
+  double run_ms = 0.0;
+  double kernel_ms = 0.0;
+  double batch = 0.0;
+  uint32_t max_depth = 0;
+  int ok = 0;
+  int errors = 0;
+  int mismatches = 0;
+};
+
+
+typedef std::chrono::steady_clock Clock;
+
+
+/** One client: keeps up to cfg.inflight jobs submitted and validates every reply */
+void runClient(const Config & cfg, int id, const float *in, const float *ref, ClientStats & st)
+{
+  const int n_inflight = std::max(1, std::min(cfg.inflight, cfg.jobs));
+  const float mask[3 * 3] = {
+    1, 1, 1,
+    1, 1, 1,
+    1, 1, 1
+  };
+
+  ipc::Client client;
+  if (!client.connect(cfg.socket.c_str()))
+  {
+    st.errors = cfg.jobs;
+    return;
+  }
+
+  // kazdy frame ma vlastny shared memory objekt, vstup sa nakopiruje iba raz
+  std::vector<std::unique_ptr<ipc::Frame> > frames;
+  for (int k = 0; k < n_inflight; ++k)
+  {
+    std::string name = "corr_load_" + std::to_string(getpid()) + "_" + std::to_string(id) + "_" + std::to_string(k);
+    frames.emplace_back(new ipc::Frame);
+    if (!frames.back()->create(name.c_str(), cfg.w, cfg.h))
+    {
+      st.errors = cfg.jobs;
+      return;
+    }
+    std::memcpy(frames.back()->in(), in, sizeof(float) * (cfg.w + 2) * (cfg.h + 2));
+  }
+
+  std::vector<Clock::time_point> submitted(n_inflight);
+  int n_submitted = 0;
+
+  for (int done = 0; done < cfg.jobs; ++done)
+  {
+    // dopln rozpracovane ulohy (uloha i pouziva frame i % n_inflight)
+    while ((n_submitted < cfg.jobs) && (n_submitted < done + n_inflight))
+    {
+      ipc::Frame & frame = *frames[n_submitted % n_inflight];
+      std::fill(frame.out(), frame.out() + size_t(cfg.w) * cfg.h, 0.0f);
+
+      uint32_t job_id;
+      submitted[n_submitted % n_inflight] = Clock::now();
+      if (!client.submit(frame, mask, cfg.program.c_str(), job_id))
+      {
+        st.errors += cfg.jobs - done;
+        return;
+      }
+      ++n_submitted;
+    }
+
+    ipc::Reply reply;
+    if (!client.wait(reply))
+    {
+      st.errors += cfg.jobs - done;
+      return;
+    }
+
+    auto end = Clock::now();
+    st.latency_ms.push_back(std::chrono::duration <double, std::milli>(end - submitted[done % n_inflight]).count());
+
+    if (reply.status != ipc::Ok)
+    {
+      std::cerr << "Client " << id << ": job " << reply.job_id << " failed with status " << reply.status << std::endl;
+      ++st.errors;
+      continue;
+    }
+
+    ++st.ok;
+    st.queue_ms += reply.queue_ns * 1e-6;
+    st.run_ms += reply.run_ns * 1e-6;
+    st.kernel_ms += reply.kernel_ns * 1e-6;
+    st.batch += reply.batch_size;
+    st.max_depth = std::max(st.max_depth, reply.queue_depth);
+
+    validate::Report r = validate::compare(ref, frames[done % n_inflight]->out(), cfg.w, cfg.h, 1);
+    if (r.max_abs_err > 1e-4 * std::max(1.0f, std::fabs(r.worst_ref))) ++st.mismatches;
+  }
+}
+
+
+bool parseArgs(int argc, char *argv[], Config & cfg)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const char *eq = std::strchr(argv[i], '=');
+    if (eq == nullptr)
+    {
+      std::cerr << "Invalid argument (expected NAME=value): " << argv[i] << std::endl;
+      return false;
+    }
+
+    std::string key(argv[i], eq - argv[i]);
+    const char *val = eq + 1;
+
+    if (key == "SOCKET") cfg.socket = val;
+    else if (key == "CLIENTS") cfg.clients = std::atoi(val);
+    else if (key == "JOBS") cfg.jobs = std::atoi(val);
+    else if (key == "INFLIGHT") cfg.inflight = std::atoi(val);
+    else if (key == "W") cfg.w = std::atoi(val);
+    else if (key == "H") cfg.h = std::atoi(val);
+    else if (key == "PROGRAM") cfg.program = val;
+    else if (key == "SEED") cfg.seed = std::strtoull(val, nullptr, 0);
+    else
+    {
+      std::cerr << "Unknown parameter: " << key << std::endl;
+      return false;
+    }
+  }
+
+  if ((cfg.clients <= 0) || (cfg.jobs <= 0) || (cfg.inflight <= 0) || (cfg.w <= 0) || (cfg.h <= 0))
+  {
+    std::cerr << "CLIENTS, JOBS, INFLIGHT, W and H have to be positive" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+double percentile(const std::vector<double> & v, double p)
+{
+  return v[std::min(v.size() - 1, size_t(p * v.size()))];
+}
+
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  Config cfg;
+  if (!parseArgs(argc, argv, cfg)) return 1;
+
+  // vstup a referencny vysledok su spolocne pre vsetkych klientov
+  const float *in;
+  float *ref, *unused;
+  input::genRandom(in, ref, unused, cfg.w, cfg.h, 1, false, cfg.seed);
+
+  const float mask[3 * 3] = {
+    1, 1, 1,
+    1, 1, 1,
+    1, 1, 1
+  };
+  box_filter::corrReferenceRadius(in, mask, ref, cfg.w, cfg.h, 1);
+
+  std::cout << "Clients: " << cfg.clients << ", jobs per client: " << cfg.jobs
+            << ", in flight: " << cfg.inflight << ", size: " << cfg.w << "x" << cfg.h
+            << ", program: " << cfg.program << ", seed: " << cfg.seed << std::endl;
+
+  std::vector<ClientStats> stats(cfg.clients);
+
+  auto start = Clock::now();
+  parallelFor(cfg.clients, cfg.clients, [&](int, int c0, int c1) {
+    for (int c = c0; c < c1; ++c) runClient(cfg, c, in, ref, stats[c]);
+  });
+  auto end = Clock::now();
+
+  // sumarizacia
+  ClientStats all;
+  for (const ClientStats & st : stats)
+  {
+    all.latency_ms.insert(all.latency_ms.end(), st.latency_ms.begin(), st.latency_ms.end());
+    all.queue_ms += st.queue_ms;
+    all.run_ms += st.run_ms;
+    all.kernel_ms += st.kernel_ms;
+    all.batch += st.batch;
+    all.max_depth = std::max(all.max_depth, st.max_depth);
+    all.ok += st.ok;
+    all.errors += st.errors;
+    all.mismatches += st.mismatches;
+  }
+
+  double total_ms = std::chrono::duration <double, std::milli>(end - start).count();
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "Completed jobs: " << all.latency_ms.size() << " in " << total_ms << " ms ("
+            << (all.latency_ms.size() / (total_ms * 1e-3)) << " jobs/s)" << std::endl;
+
+  if (!all.latency_ms.empty())
+  {
+    std::sort(all.latency_ms.begin(), all.latency_ms.end());
+    std::cout << "Round trip latency: p50=" << percentile(all.latency_ms, 0.50)
+              << " p90=" << percentile(all.latency_ms, 0.90)
+              << " p99=" << percentile(all.latency_ms, 0.99)
+              << " max=" << all.latency_ms.back() << " ms" << std::endl;
+  }
+
+  if (all.ok > 0)
+  {
+    std::cout << "Server: queue=" << (all.queue_ms / all.ok) << " ms, run=" << (all.run_ms / all.ok)
+              << " ms, kernel=" << (all.kernel_ms / all.ok) << " ms, batch=" << (all.batch / all.ok)
+              << ", max_depth=" << all.max_depth << std::endl;
+  }
+
+  std::cout << "Errors: " << all.errors << ", mismatches: " << all.mismatches << std::endl;
+
+  delete [] in;
+  delete [] ref;
+  delete [] unused;
+
+  return ((all.errors == 0) && (all.mismatches == 0)) ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Load generator for the correlation server
+# (OpenCL_local_memory --server), does not need OpenCL
+#
+#-------------------------------------------------
+
+QT -= core gui
+
+TARGET = corr_load
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += -std=c++11 -Wall -Wextra -pedantic -g -pthread
+LIBS += -pthread -lrt
+
+HEADERS += \
+    ipc.h \
+    input.h \
+    box_filter.h \
+    validate.h \
+    parallel.h
+SOURCES += corr_load.cpp \
+    ipc.cpp \
+    input.cpp \
+    box_filter.cpp \
+    validate.cpp
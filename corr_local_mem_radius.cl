@@ -0,0 +1,66 @@
+#define IDX(x, y, size) ((x) + (size) * (y))
+
+//#pragma OPENCL EXTENSION cl_amd_printf : enable
+
+
+/**********************************************
+ * Same tiling as corr_local_mem.cl, but for a mask of arbitrary radius RADIUS
+ * (mask size (2 * RADIUS + 1) x (2 * RADIUS + 1)).
+ * The tile together with its halo is loaded cooperatively by all work-items
+ * of the work-group, the halo is no longer loaded by dedicated warps.
+ * Used as the generic kernel the box filter is compared against.
+ */
+
+//#define TILE_W 32 //64
+//#define TILE_H 32 //64
+//#define WG_W 32 //64
+//#define WG_H 8  //4
+//#define RADIUS 1
+#define WG_SIZE ((WG_W) * (WG_H))  // 256
+
+#define MASK_W (2 * (RADIUS) + 1)
+#define CACHE_W ((TILE_W) + 2 * (RADIUS))
+#define CACHE_H ((TILE_H) + 2 * (RADIUS))
+
+
+__kernel void corr(__global   const float *in,
+                   __constant const float *mask,
+                   __global         float *out,
+                   const int in_row_pitch,
+                   const int out_row_pitch)
+{
+  __local float cache[CACHE_H][CACHE_W];
+
+  int gi_0 = get_group_id(0) * TILE_W;
+  int gj_0 = get_group_id(1) * TILE_H;
+
+  int li = get_local_id(0);
+  int lj = get_local_id(1);
+  int lid = li + lj * WG_W;
+
+  // nacitanie tilu aj s okrajom z globalnej do lokalnej pamate
+  for (int idx = lid; idx < (CACHE_W * CACHE_H); idx += WG_SIZE)
+  {
+    int ci = idx % CACHE_W;
+    int cj = idx / CACHE_W;
+    cache[cj][ci] = in[(gi_0 + ci) + (gj_0 + cj) * in_row_pitch];
+  }
+
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  // Vypocet korelacie
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    float sum = 0.0f;
+
+    for (int j = -RADIUS; j <= RADIUS; ++j)
+    {
+      for (int i = -RADIUS; i <= RADIUS; ++i)
+      {
+        sum += cache[lj + RADIUS + k + j][li + RADIUS + i] * mask[IDX(i + RADIUS, j + RADIUS, MASK_W)];
+      }
+    }
+
+    out[IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch)] = sum;
+  }
+}
@@ -0,0 +1,113 @@
+#define IDX(x, y, size) ((x) + (size) * (y))
+
+//#pragma OPENCL EXTENSION cl_amd_printf : enable
+
+#if defined(USE_INTEL_SUBGROUPS)
+#pragma OPENCL EXTENSION cl_intel_subgroups : enable
+#define SHUFFLE(x, lane) intel_sub_group_shuffle((x), (lane))
+#else
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+#pragma OPENCL EXTENSION cl_khr_subgroup_shuffle : enable
+#define SHUFFLE(x, lane) sub_group_shuffle((x), (lane))
+#endif
+
+
+/**********************************************
+ * Every workgroup is processing data in tiles of width TILE_W and height TILE_H,
+ * same as in corr_local_mem.cl, but no local memory and no barrier is used.
+ * Each work-item owns one column of the tile and walks down a strip of
+ * TILE_H / WG_H rows, keeping the three rows of the correlation window
+ * in registers (vertical halo).
+ * The left and right neighbours of a pixel are taken from the registers
+ * of the neighbouring work-items in the sub-group via a shuffle (horizontal halo).
+ * Only the work-items on the edge of a sub-group (or of the tile) read their
+ * missing neighbour from global memory, so the kernel does not depend
+ * on the sub-group size the compiler picks.
+ * The shuffle assumes, that the neighbouring lane holds the neighbouring column,
+ * i.e. that lanes follow the linear local id. OpenCL leaves the mapping of work-items
+ * to sub-groups to the implementation, so every work-item checks the local id
+ * of its neighbouring lanes first and reads from global memory, where they differ.
+ */
+
+//#define TILE_W 32 //64
+//#define TILE_H 32 //64
+#define TILE_SIZE ((TILE_W) * (TILE_H))  // 4096
+
+//#define WG_W 32 //64
+//#define WG_H 8  //4
+#define WG_SIZE ((WG_W) * (WG_H))  // 256
+
+#define STRIP_H ((TILE_H) / (WG_H))
+
+
+/**
+ * Loads one row of the correlation window for the column owned by this work-item.
+ * The shuffles have to be executed by all work-items in the sub-group,
+ * so the halo values from global memory are only selected after them.
+ */
+void loadRow(__global const float *in_row, int gi, bool left_edge, bool right_edge,
+             uint lane, float *l, float *c, float *r)
+{
+  float center = in_row[gi];
+  float left   = SHUFFLE(center, (left_edge)  ? lane : lane - 1);
+  float right  = SHUFFLE(center, (right_edge) ? lane : lane + 1);
+
+  *l = (left_edge)  ? in_row[gi - 1] : left;
+  *c = center;
+  *r = (right_edge) ? in_row[gi + 1] : right;
+}
+
+
+__kernel void corr(__global   const float *in,
+                   __constant const float *mask,
+                   __global         float *out,
+                   const int in_row_pitch,
+                   const int out_row_pitch)
+{
+  int gi_0 = get_group_id(0) * TILE_W;
+  int gj_0 = get_group_id(1) * TILE_H;
+
+  int li = get_local_id(0);
+  int lj = get_local_id(1);
+
+  int lid = li + lj * WG_W;
+
+  uint lane    = get_sub_group_local_id();
+  uint sg_size = get_sub_group_size();
+
+  // lokalne id susednych lanov (na okraji sub-groupy vlastne id)
+  int left_lid  = SHUFFLE(lid, (lane == 0) ? lane : lane - 1);
+  int right_lid = SHUFFLE(lid, (lane == (sg_size - 1)) ? lane : lane + 1);
+
+  // work-itemy na okraji sub-groupy (alebo tilu) nemaju suseda v registroch,
+  // rovnako ak susedny lane nespracovava susedny stlpec
+  bool left_edge  = (li == 0) || (left_lid != (lid - 1));
+  bool right_edge = (li == (WG_W - 1)) || (right_lid != (lid + 1));
+
+  int gi = gi_0 + li + 1;               // stlpec vo vstupnych datach (vratane halo)
+  int gj = gj_0 + lj * STRIP_H + 1;     // prvy riadok pasu vo vstupnych datach (vratane halo)
+
+  // nacitanie prvych dvoch riadkov okna
+  float l0, c0, r0;
+  float l1, c1, r1;
+  float l2, c2, r2;
+
+  loadRow(in + (gj - 1) * in_row_pitch, gi, left_edge, right_edge, lane, &l0, &c0, &r0);
+  loadRow(in + gj * in_row_pitch,       gi, left_edge, right_edge, lane, &l1, &c1, &r1);
+
+  // Vypocet korelacie
+  for (int k = 0; k < STRIP_H; ++k)
+  {
+    loadRow(in + (gj + k + 1) * in_row_pitch, gi, left_edge, right_edge, lane, &l2, &c2, &r2);
+
+    float sum = l0 * mask[0] + c0 * mask[1] + r0 * mask[2] +
+                l1 * mask[3] + c1 * mask[4] + r1 * mask[5] +
+                l2 * mask[6] + c2 * mask[7] + r2 * mask[8];
+
+    out[IDX(gi - 1, gj - 1 + k, out_row_pitch)] = sum;
+
+    // posunutie okna o riadok nizsie
+    l0 = l1; c0 = c1; r0 = r1;
+    l1 = l2; c1 = c2; r1 = r2;
+  }
+}
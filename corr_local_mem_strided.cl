@@ -0,0 +1,77 @@
+#define IDX(x, y, size) ((x) + (size) * (y))
+
+//#pragma OPENCL EXTENSION cl_amd_printf : enable
+
+
+/**********************************************
+ * Correlation evaluated only at every STRIDE-th pixel in both directions.
+ * Every workgroup computes an output tile of TILE_W x TILE_H decimated pixels,
+ * so it loads the input footprint of the tile, which is
+ * ((TILE_W - 1) * STRIDE + 3) x ((TILE_H - 1) * STRIDE + 3) pixels including the halo.
+ * The footprint is loaded cooperatively by all work-items of the work-group.
+ * Only pixels inside out_w x out_h are written, starting at out_offset,
+ * so the output can be placed into the interior of a buffer with a halo
+ * (used by the pyramid builder to chain levels without host round trips).
+ */
+
+//#define TILE_W 32 //64
+//#define TILE_H 8
+//#define WG_W 32 //64
+//#define WG_H 8  //4
+//#define STRIDE 2
+#define WG_SIZE ((WG_W) * (WG_H))  // 256
+
+#define CACHE_W (((TILE_W) - 1) * (STRIDE) + 3)
+#define CACHE_H (((TILE_H) - 1) * (STRIDE) + 3)
+
+
+__kernel void corr(__global   const float *in,
+                   __constant const float *mask,
+                   __global         float *out,
+                   const int in_row_pitch,
+                   const int out_row_pitch,
+                   const int out_offset,
+                   const int out_w,
+                   const int out_h)
+{
+  __local float cache[CACHE_H][CACHE_W];
+
+  // lavy horny roh tilu vo vystupnych (decimovanych) suradniciach
+  int gi_0 = get_group_id(0) * TILE_W;
+  int gj_0 = get_group_id(1) * TILE_H;
+
+  int li = get_local_id(0);
+  int lj = get_local_id(1);
+  int lid = li + lj * WG_W;
+
+  // nacitanie vstupnej oblasti tilu aj s okrajom z globalnej do lokalnej pamate
+  __global const float *in_tile = in + (gi_0 * STRIDE) + (gj_0 * STRIDE) * in_row_pitch;
+
+  for (int idx = lid; idx < (CACHE_W * CACHE_H); idx += WG_SIZE)
+  {
+    int ci = idx % CACHE_W;
+    int cj = idx / CACHE_W;
+    cache[cj][ci] = in_tile[ci + cj * in_row_pitch];
+  }
+
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  // Vypocet korelacie
+  for (int k = 0; k < TILE_H; k += WG_H)
+  {
+    float sum = 0.0f;
+
+    for (int j = -1; j <= 1; ++j)
+    {
+      for (int i = -1; i <= 1; ++i)
+      {
+        sum += cache[(lj + k) * STRIDE + 1 + j][li * STRIDE + 1 + i] * mask[IDX(i + 1, j + 1, 3)];
+      }
+    }
+
+    if (((gi_0 + li) < out_w) && ((gj_0 + lj + k) < out_h))
+    {
+      out[out_offset + IDX(gi_0 + li, gj_0 + lj + k, out_row_pitch)] = sum;
+    }
+  }
+}
@@ -0,0 +1,323 @@
+#include "image_io.h"
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cctype>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+#define IO_REPORT(msg) \
+  do { \
+    std::cerr << msg << std::endl; \
+    return false; \
+  } while (0)
+
+
+
+namespace {
+
+/** Reads an unsigned integer of given size from a possibly big endian TIFF file */
+uint32_t readUInt(const unsigned char *p, int size, bool big_endian)
+{
+  uint32_t val = 0;
+
+  for (int i = 0; i < size; ++i)
+  {
+    int shift = big_endian ? (8 * (size - 1 - i)) : (8 * i);
+    val |= uint32_t(p[i]) << shift;
+  }
+
+  return val;
+}
+
+
+/** Skips white space and comments in PGM header */
+size_t skipPGMSpace(const unsigned char *data, size_t pos, size_t size)
+{
+  while (pos < size)
+  {
+    if (data[pos] == '#')
+    {
+      while ((pos < size) && (data[pos] != '\n')) ++pos;
+    }
+    else if (std::isspace(data[pos]))
+    {
+      ++pos;
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  return pos;
+}
+
+
+bool readPGMNumber(const unsigned char *data, size_t & pos, size_t size, int & val)
+{
+  pos = skipPGMSpace(data, pos, size);
+  if ((pos >= size) || (!std::isdigit(data[pos]))) return false;
+
+  val = 0;
+  while ((pos < size) && std::isdigit(data[pos]))
+  {
+    val = val * 10 + (data[pos] - '0');
+    ++pos;
+  }
+
+  return true;
+}
+
+}
+
+
+namespace image_io {
+
+int bytesPerPixel(PixelType type)
+{
+  switch (type)
+  {
+    case UInt8:   return 1;
+    case UInt16:  return 2;
+    case Float32: return 4;
+  }
+
+  return 0;
+}
+
+
+/**************************************** INPUT ****************************************/
+
+bool InputImage::open(const char *path, int raw_w, int raw_h, PixelType raw_type)
+{
+  close();
+
+  m_fd = ::open(path, O_RDONLY);
+  if (m_fd < 0) IO_REPORT("Failed to open input file " << path << ": " << std::strerror(errno));
+
+  struct stat st;
+  if (fstat(m_fd, &st) != 0) IO_REPORT("Failed to stat input file " << path);
+  m_size = size_t(st.st_size);
+  if (m_size == 0) IO_REPORT("Input file " << path << " is empty");
+
+  void *p = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (p == MAP_FAILED) IO_REPORT("Failed to map input file " << path << ": " << std::strerror(errno));
+  m_data = static_cast<const unsigned char *>(p);
+
+  // data sa citaju po riadkoch od zaciatku do konca
+  madvise(p, m_size, MADV_SEQUENTIAL);
+
+  if ((m_size >= 2) && (m_data[0] == 'P') && (m_data[1] == '5'))
+  {
+    return parsePGM();
+  }
+
+  if ((m_size >= 4) && (((m_data[0] == 'I') && (m_data[1] == 'I') && (m_data[2] == 42) && (m_data[3] == 0)) ||
+                        ((m_data[0] == 'M') && (m_data[1] == 'M') && (m_data[2] == 0) && (m_data[3] == 42))))
+  {
+    return parseTIFF();
+  }
+
+  // raw subor bez hlavicky
+  if ((raw_w <= 0) || (raw_h <= 0)) IO_REPORT("Width and height have to be given for raw input file " << path);
+
+  m_w = raw_w;
+  m_h = raw_h;
+  m_type = raw_type;
+  m_big_endian = false;
+  m_rows_per_strip = m_h;
+  m_strip_offsets.assign(1, 0);
+
+  if (m_size != rowBytes() * size_t(m_h))
+  {
+    IO_REPORT("Size of raw input file " << path << " (" << m_size << " bytes) does not match "
+              << m_w << "x" << m_h << "x" << bytesPerPixel(m_type) << " bytes");
+  }
+
+  return true;
+}
+
+
+void InputImage::close(void)
+{
+  if (m_data != nullptr) munmap(const_cast<unsigned char *>(m_data), m_size);
+  if (m_fd >= 0) ::close(m_fd);
+
+  m_fd = -1;
+  m_data = nullptr;
+  m_size = 0;
+  m_w = m_h = 0;
+  m_strip_offsets.clear();
+}
+
+
+bool InputImage::parsePGM(void)
+{
+  size_t pos = 2;
+  int maxval = 0;
+
+  if ((!readPGMNumber(m_data, pos, m_size, m_w)) ||
+      (!readPGMNumber(m_data, pos, m_size, m_h)) ||
+      (!readPGMNumber(m_data, pos, m_size, maxval)))
+  {
+    IO_REPORT("Invalid PGM header");
+  }
+
+  // za maxval nasleduje prave jeden biely znak a potom binarne data
+  ++pos;
+
+  if ((m_w <= 0) || (m_h <= 0) || (maxval <= 0) || (maxval > 65535)) IO_REPORT("Invalid PGM header");
+
+  m_type = (maxval < 256) ? UInt8 : UInt16;
+  m_big_endian = true;          // 16 bitove PGM su vzdy big endian
+  m_rows_per_strip = m_h;
+  m_strip_offsets.assign(1, pos);
+
+  if ((pos + rowBytes() * size_t(m_h)) > m_size) IO_REPORT("PGM file is truncated");
+
+  return true;
+}
+
+
+bool InputImage::parseTIFF(void)
+{
+  bool be = (m_data[0] == 'M');
+  m_big_endian = be;
+
+  if (m_size < 8) IO_REPORT("TIFF file is truncated");
+  size_t ifd = readUInt(m_data + 4, 4, be);
+  if ((ifd + 2) > m_size) IO_REPORT("Invalid TIFF IFD offset");
+
+  int n_entries = readUInt(m_data + ifd, 2, be);
+  if ((ifd + 2 + size_t(n_entries) * 12) > m_size) IO_REPORT("TIFF IFD is truncated");
+
+  int bits = 1, compression = 1, samples = 1, sample_format = 1;
+  uint32_t n_strips = 0, strip_offsets_type = 0, strip_offsets_pos = 0;
+  m_rows_per_strip = 0;
+
+  for (int e = 0; e < n_entries; ++e)
+  {
+    const unsigned char *entry = m_data + ifd + 2 + e * 12;
+    uint32_t tag   = readUInt(entry, 2, be);
+    uint32_t type  = readUInt(entry + 2, 2, be);
+    uint32_t count = readUInt(entry + 4, 4, be);
+    uint32_t val   = (type == 3) ? readUInt(entry + 8, 2, be) : readUInt(entry + 8, 4, be);   // SHORT alebo LONG
+
+    switch (tag)
+    {
+      case 256: m_w = int(val); break;                 // ImageWidth
+      case 257: m_h = int(val); break;                 // ImageLength
+      case 258: bits = int(val); break;                // BitsPerSample
+      case 259: compression = int(val); break;         // Compression
+      case 277: samples = int(val); break;             // SamplesPerPixel
+      case 278: m_rows_per_strip = int(val); break;    // RowsPerStrip
+      case 339: sample_format = int(val); break;       // SampleFormat
+      case 273:                                        // StripOffsets
+        n_strips = count;
+        strip_offsets_type = type;
+        // hodnoty su ulozene priamo v polozke ak sa zmestia do 4 bytov
+        strip_offsets_pos = ((count * ((type == 3) ? 2 : 4)) <= 4) ? uint32_t((entry + 8) - m_data) : readUInt(entry + 8, 4, be);
+        break;
+      default: break;
+    }
+  }
+
+  if (compression != 1) IO_REPORT("Compressed TIFF files are not supported");
+  if (samples != 1) IO_REPORT("Only single channel TIFF files are supported");
+  if ((m_w <= 0) || (m_h <= 0) || (n_strips == 0)) IO_REPORT("Invalid TIFF image");
+
+  if ((bits == 8) && (sample_format == 1)) m_type = UInt8;
+  else if ((bits == 16) && (sample_format == 1)) m_type = UInt16;
+  else if ((bits == 32) && (sample_format == 3)) m_type = Float32;
+  else IO_REPORT("Unsupported TIFF pixel format (" << bits << " bits, sample format " << sample_format << ")");
+
+  if ((m_rows_per_strip <= 0) || (m_rows_per_strip > m_h)) m_rows_per_strip = m_h;
+  if (n_strips != uint32_t((m_h + m_rows_per_strip - 1) / m_rows_per_strip)) IO_REPORT("Invalid number of TIFF strips");
+
+  int offset_size = (strip_offsets_type == 3) ? 2 : 4;
+  if ((strip_offsets_pos + size_t(n_strips) * offset_size) > m_size) IO_REPORT("TIFF strip offsets are truncated");
+
+  m_strip_offsets.resize(n_strips);
+  for (uint32_t s = 0; s < n_strips; ++s)
+  {
+    m_strip_offsets[s] = readUInt(m_data + strip_offsets_pos + s * offset_size, offset_size, be);
+
+    int rows = stripRows(s * m_rows_per_strip);
+    if ((m_strip_offsets[s] + rowBytes() * size_t(rows)) > m_size) IO_REPORT("TIFF strip " << s << " is truncated");
+  }
+
+  return true;
+}
+
+
+/**************************************** OUTPUT ****************************************/
+
+bool OutputImage::create(const char *path, int w, int h)
+{
+  close();
+
+  m_w = w;
+  m_h = h;
+  m_size = rowBytes() * size_t(h);
+
+  m_fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (m_fd < 0) IO_REPORT("Failed to create output file " << path << ": " << std::strerror(errno));
+
+  if (ftruncate(m_fd, off_t(m_size)) != 0) IO_REPORT("Failed to resize output file " << path << ": " << std::strerror(errno));
+
+  void *p = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (p == MAP_FAILED) IO_REPORT("Failed to map output file " << path << ": " << std::strerror(errno));
+  m_data = static_cast<unsigned char *>(p);
+
+  madvise(p, m_size, MADV_SEQUENTIAL);
+
+  return true;
+}
+
+
+bool OutputImage::flushRows(int j, int n)
+{
+  // msync vyzaduje adresu zarovnanu na velkost stranky
+  size_t page = size_t(sysconf(_SC_PAGESIZE));
+  size_t begin = (size_t(j) * rowBytes() / page) * page;
+  size_t end = size_t(j + n) * rowBytes();
+
+  if (msync(m_data + begin, end - begin, MS_ASYNC) != 0) IO_REPORT("Failed to flush output rows: " << std::strerror(errno));
+
+  return true;
+}
+
+
+bool OutputImage::sync(void)
+{
+  if (msync(m_data, m_size, MS_SYNC) != 0) IO_REPORT("Failed to write back output file: " << std::strerror(errno));
+  return true;
+}
+
+
+bool OutputImage::close(void)
+{
+  bool ok = true;
+
+  if (m_data != nullptr)
+  {
+    if (msync(m_data, m_size, MS_SYNC) != 0) ok = false;
+    munmap(m_data, m_size);
+  }
+
+  if (m_fd >= 0) ::close(m_fd);
+
+  m_fd = -1;
+  m_data = nullptr;
+  m_size = 0;
+
+  return ok;
+}
+
+} // End of image_io namespace
@@ -0,0 +1,111 @@
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <cstddef>
+#include <vector>
+
+namespace image_io {
+
+enum PixelType { UInt8, UInt16, Float32 };
+
+int bytesPerPixel(PixelType type);
+
+
+/**
+ * Read only, memory mapped input image.
+ * Supported are raw files (the size and pixel type have to be given), binary PGM (P5, 8 or 16 bit)
+ * and uncompressed single channel TIFF stored in strips (8/16 bit unsigned or 32 bit float).
+ * The pixels are never copied, row(j) points directly into the mapped file.
+ * Consecutive rows are contiguous in the file only within one strip
+ * (raw and PGM files consist of a single strip).
+ */
+class InputImage
+{
+  public:
+    InputImage(void) { }
+    ~InputImage(void) { close(); }
+
+    InputImage(const InputImage &) = delete;
+    InputImage & operator=(const InputImage &) = delete;
+
+    bool open(const char *path, int raw_w = 0, int raw_h = 0, PixelType raw_type = Float32);
+    void close(void);
+
+    int width(void) const { return m_w; }
+    int height(void) const { return m_h; }
+    PixelType type(void) const { return m_type; }
+    bool isBigEndian(void) const { return m_big_endian; }
+    size_t rowBytes(void) const { return size_t(m_w) * bytesPerPixel(m_type); }
+    size_t fileSize(void) const { return m_size; }
+
+    /** Returns a pointer to the first pixel of row j */
+    const void *row(int j) const
+    {
+      return m_data + m_strip_offsets[j / m_rows_per_strip] + size_t(j % m_rows_per_strip) * rowBytes();
+    }
+
+    /** Returns the number of rows starting at row j that are stored contiguously */
+    int stripRows(int j) const
+    {
+      int n = m_rows_per_strip - (j % m_rows_per_strip);
+      return ((j + n) > m_h) ? (m_h - j) : n;
+    }
+
+  private:
+    bool parsePGM(void);
+    bool parseTIFF(void);
+
+  private:
+    int m_fd = -1;
+    const unsigned char *m_data = nullptr;
+    size_t m_size = 0;
+    int m_w = 0;
+    int m_h = 0;
+    PixelType m_type = Float32;
+    bool m_big_endian = false;
+    int m_rows_per_strip = 1;
+    std::vector<size_t> m_strip_offsets;
+};
+
+
+/**
+ * Memory mapped output file with raw 32 bit float pixels (w * h * sizeof(float) bytes, no header).
+ * The results are written directly into the mapping in strips of rows
+ * and each finished strip is handed over to the kernel for write back.
+ */
+class OutputImage
+{
+  public:
+    OutputImage(void) { }
+    ~OutputImage(void) { close(); }
+
+    OutputImage(const OutputImage &) = delete;
+    OutputImage & operator=(const OutputImage &) = delete;
+
+    bool create(const char *path, int w, int h);
+    bool close(void);
+
+    int width(void) const { return m_w; }
+    int height(void) const { return m_h; }
+    size_t rowBytes(void) const { return size_t(m_w) * sizeof(float); }
+    size_t fileSize(void) const { return m_size; }
+
+    float *row(int j) { return reinterpret_cast<float *>(m_data + size_t(j) * rowBytes()); }
+
+    /** Starts the write back of rows [j, j + n) */
+    bool flushRows(int j, int n);
+
+    /** Waits until the whole file is written back */
+    bool sync(void);
+
+  private:
+    int m_fd = -1;
+    unsigned char *m_data = nullptr;
+    size_t m_size = 0;
+    int m_w = 0;
+    int m_h = 0;
+};
+
+} // End of image_io namespace
+
+#endif // IMAGE_IO_H
@@ -1,17 +1,44 @@
 #include "input.h"
+#include "parallel.h"
 
-#include <limits>
-#include <cstdlib>
-#include <ctime>
 #include <cstring>
+#include <iostream>
+#include <iomanip>
 
 
 
 namespace {
 
-float random(float min, float max) { return (float(rand()) / float(RAND_MAX)) * (max - min) + min; }
-float random(float max) { return random(std::numeric_limits<float>::min(), max); }
-float random(void) { return random(std::numeric_limits<float>::min(), std::numeric_limits<float>::max()); }
+/**
+ * Counter based pseudo random generator Philox4x32-10 (Salmon et al., "Parallel random numbers:
+ * as easy as 1, 2, 3"). The output depends only on the counter and the key (seed),
+ * so every pixel can be generated independently and in any order.
+ */
+void philox4x32(uint32_t ctr[4], uint32_t key0, uint32_t key1)
+{
+  const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+  const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+
+  for (int r = 0; r < 10; ++r)
+  {
+    uint64_t p0 = uint64_t(M0) * ctr[0];
+    uint64_t p1 = uint64_t(M1) * ctr[2];
+
+    uint32_t c0 = uint32_t(p1 >> 32) ^ ctr[1] ^ key0;
+    uint32_t c1 = uint32_t(p1);
+    uint32_t c2 = uint32_t(p0 >> 32) ^ ctr[3] ^ key1;
+    uint32_t c3 = uint32_t(p0);
+
+    ctr[0] = c0; ctr[1] = c1; ctr[2] = c2; ctr[3] = c3;
+
+    key0 += W0;
+    key1 += W1;
+  }
+}
+
+
+/** Converts 32 random bits to a float in [min, max) */
+float toFloat(uint32_t bits, float min, float max) { return float(bits >> 8) * (1.0f / 16777216.0f) * (max - min) + min; }
 
 }
 
@@ -86,7 +113,43 @@ void genSequential(const float * & in, float * & out_cpp, float * & out_ocl, int
 }
 
 
-void genRandom(const float * & in, float * & out_cpp, float * & out_ocl, int w, int h, int border_size, bool fill_border)
+bool selfTest(void)
+{
+  // vektory z kat_vectors v Random123 (counter, key, ocakavany vysledok)
+  static const uint32_t kat[][10] = {
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,  0x00000000, 0x00000000,
+      0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+    { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,  0xffffffff, 0xffffffff,
+      0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+    { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344,  0xa4093822, 0x299f31d0,
+      0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }
+  };
+
+  bool ok = true;
+
+  for (const uint32_t *v : kat)
+  {
+    uint32_t ctr[4] = { v[0], v[1], v[2], v[3] };
+    philox4x32(ctr, v[4], v[5]);
+
+    if ((ctr[0] != v[6]) || (ctr[1] != v[7]) || (ctr[2] != v[8]) || (ctr[3] != v[9]))
+    {
+      std::cerr << std::hex << std::setfill('0')
+                << "Philox4x32-10 mismatch for key " << std::setw(8) << v[4] << " " << std::setw(8) << v[5]
+                << ": got " << std::setw(8) << ctr[0] << " " << std::setw(8) << ctr[1]
+                << " " << std::setw(8) << ctr[2] << " " << std::setw(8) << ctr[3]
+                << ", expected " << std::setw(8) << v[6] << " " << std::setw(8) << v[7]
+                << " " << std::setw(8) << v[8] << " " << std::setw(8) << v[9]
+                << std::dec << std::setfill(' ') << std::endl;
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+
+void genRandom(const float * & in, float * & out_cpp, float * & out_ocl, int w, int h, int border_size, bool fill_border, uint64_t seed)
 {
   const int w_size = (w + 2 * border_size);
   const int h_size = (h + 2 * border_size);
@@ -95,25 +158,37 @@ void genRandom(const float * & in, float * & out_cpp, float * & out_ocl, int w,
   float *out_cpp_ = new float[n];
   float *out_ocl_ = new float[n];
 
-  srand(time(nullptr));
+  const uint32_t key0 = uint32_t(seed);
+  const uint32_t key1 = uint32_t(seed >> 32);
 
-  for (int j = 0; j < h_size; ++j)
-  {
-    for (int i = 0; i < w_size; ++i)
+  // kazde vlakno generuje svoj pas riadkov, hodnota pixelu zavisi iba od jeho indexu a seedu
+  parallelFor(h_size, 0, [=](int, int j0, int j1) {
+    for (int j = j0; j < j1; ++j)
     {
-      int idx = i + j * w_size;
-      if ((!fill_border) &&
-          ((i < border_size) || (i > (w_size - 1 - border_size)) ||
-           (j < border_size) || (j > (h_size - 1 - border_size))))
+      for (int i = 0; i < w_size; i += 4)
       {
-        in_[idx] = 0.0f;
-      }
-      else
-      {
-        in_[idx] = random(0.0f, 100.0f);
+        uint64_t idx = uint64_t(i) + uint64_t(j) * w_size;
+        uint32_t ctr[4] = { uint32_t(idx), uint32_t(idx >> 32), 0, 0 };
+        philox4x32(ctr, key0, key1);
+
+        // jedno volanie Philox-u da nahodne cisla pre 4 pixely
+        for (int k = 0; (k < 4) && ((i + k) < w_size); ++k)
+        {
+          int ii = i + k;
+          if ((!fill_border) &&
+              ((ii < border_size) || (ii > (w_size - 1 - border_size)) ||
+               (j < border_size) || (j > (h_size - 1 - border_size))))
+          {
+            in_[ii + j * w_size] = 0.0f;
+          }
+          else
+          {
+            in_[ii + j * w_size] = toFloat(ctr[k], 0.0f, 100.0f);
+          }
+        }
       }
     }
-  }
+  });
 
   in = in_;
   out_cpp = out_cpp_;
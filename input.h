@@ -1,11 +1,18 @@
 #ifndef INPUT_H
 #define INPUT_H
 
+#include <cstdint>
+
 namespace input {
 
+const uint64_t DEFAULT_SEED = 0x5EED;
+
 void genDebug(const float * & in, float * & out_cpp, float * & out_ocl, int & w, int & h);
 void genSequential(const float * & in, float * & out_cpp, float * & out_ocl, int w, int h, int border_size);
-void genRandom(const float * & in, float * & out_cpp, float * & out_ocl, int w, int h, int border_size, bool fill_border = false);
+/** Checks the random generator against the Random123 known-answer vectors of Philox4x32-10 */
+bool selfTest(void);
+
+void genRandom(const float * & in, float * & out_cpp, float * & out_ocl, int w, int h, int border_size, bool fill_border = false, uint64_t seed = DEFAULT_SEED);
 
 } // End of input namespace
 
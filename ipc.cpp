@@ -0,0 +1,236 @@
+#include "ipc.h"
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+#define IPC_REPORT(msg) \
+  do { \
+    std::cerr << msg << std::endl; \
+    return false; \
+  } while (0)
+
+
+
+namespace ipc {
+
+bool Frame::create(const char *name, int w, int h)
+{
+  close();
+
+  m_name = name;
+  m_w = w;
+  m_h = h;
+  m_size = frameBytes(w, h);
+
+  int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) IPC_REPORT("Failed to create shared memory " << name << ": " << std::strerror(errno));
+
+  // po zapecateni sa velkost uz neda zmenit, server tak nemoze dostat SIGBUS pri pristupe k framu
+  if ((ftruncate(fd, off_t(m_size)) != 0) ||
+      (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0))
+  {
+    std::cerr << "Failed to resize and seal shared memory " << name << ": " << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return false;
+  }
+
+  if (!map(fd))
+  {
+    ::close(fd);
+    return false;
+  }
+  m_fd = fd;
+
+  return true;
+}
+
+
+bool Frame::open(int fd, int w, int h)
+{
+  close();
+
+  // meno objektu od klienta sa hodi iba do vypisov, napr. "/memfd:corr_load_... (deleted)"
+  char link[256];
+  ssize_t n = readlink(("/proc/self/fd/" + std::to_string(fd)).c_str(), link, sizeof(link));
+  m_name = (n > 0) ? std::string(link, size_t(n)) : std::string("received frame");
+  m_w = w;
+  m_h = h;
+  m_size = frameBytes(w, h);
+
+  // prijaty objekt musi byt zapecateny proti zmenseniu a dost velky pre dane rozmery,
+  // inak by ho klient mohol zmensit a pristup za koncom by skoncil SIGBUS
+  int seals = fcntl(fd, F_GET_SEALS);
+  struct stat st;
+  if ((seals < 0) || ((seals & F_SEAL_SHRINK) == 0))
+  {
+    std::cerr << "Shared memory " << m_name << " is not sealed against shrinking" << std::endl;
+    ::close(fd);
+    return false;
+  }
+  if ((fstat(fd, &st) != 0) || (size_t(st.st_size) < m_size))
+  {
+    std::cerr << "Shared memory " << m_name << " is too small for " << w << "x" << h << " frame" << std::endl;
+    ::close(fd);
+    return false;
+  }
+
+  bool ok = map(fd);
+  ::close(fd);   // mapovanie zostava platne aj po zatvoreni deskriptora
+
+  return ok;
+}
+
+
+bool Frame::map(int fd)
+{
+  void *p = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) IPC_REPORT("Failed to map shared memory " << m_name << ": " << std::strerror(errno));
+
+  m_data = static_cast<float *>(p);
+
+  return true;
+}
+
+
+void Frame::close(void)
+{
+  if (m_data != nullptr) munmap(m_data, m_size);
+  if (m_fd >= 0) ::close(m_fd);
+
+  m_data = nullptr;
+  m_size = 0;
+  m_fd = -1;
+}
+
+
+bool sendAll(int fd, const void *data, size_t size)
+{
+  const char *p = static_cast<const char *>(data);
+
+  while (size > 0)
+  {
+    ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    p += n;
+    size -= size_t(n);
+  }
+
+  return true;
+}
+
+
+bool recvAll(int fd, void *data, size_t size)
+{
+  char *p = static_cast<char *>(data);
+
+  while (size > 0)
+  {
+    ssize_t n = recv(fd, p, size, 0);
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    if (n == 0) return false;   // spojenie bolo zatvorene
+    p += n;
+    size -= size_t(n);
+  }
+
+  return true;
+}
+
+
+bool Client::connect(const char *socket_path)
+{
+  close();
+
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (std::strlen(socket_path) >= sizeof(addr.sun_path)) IPC_REPORT("Socket path too long: " << socket_path);
+  std::strcpy(addr.sun_path, socket_path);
+
+  m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (m_fd < 0) IPC_REPORT("Failed to create socket: " << std::strerror(errno));
+
+  if (::connect(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+  {
+    std::cerr << "Failed to connect to " << socket_path << ": " << std::strerror(errno) << std::endl;
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+
+void Client::close(void)
+{
+  if (m_fd >= 0) ::close(m_fd);
+  m_fd = -1;
+}
+
+
+bool Client::submit(const Frame & frame, const float *mask, const char *program, uint32_t & job_id)
+{
+  if (frame.fd() < 0) IPC_REPORT("Frame " << frame.name() << " was not created by this process");
+  if (std::strlen(program) >= size_t(MAX_NAME)) IPC_REPORT("Program name too long: " << program);
+
+  Request req;
+  std::memset(&req, 0, sizeof(req));
+  req.magic = MAGIC;
+  req.job_id = job_id = m_next_id++;
+  req.w = frame.width();
+  req.h = frame.height();
+  std::memcpy(req.mask, mask, sizeof(req.mask));
+  std::strcpy(req.program, program);
+
+  // deskriptor framu sa pripoji k prvemu bajtu poziadavky, zvysok sa pripadne dosle bez neho
+  int frame_fd = frame.fd();
+  union { char buf[CMSG_SPACE(sizeof(int))]; cmsghdr align; } ctrl;
+  std::memset(&ctrl, 0, sizeof(ctrl));
+  iovec iov;
+  iov.iov_base = &req;
+  iov.iov_len = sizeof(req);
+  msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+  cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), &frame_fd, sizeof(int));
+
+  ssize_t n;
+  do n = sendmsg(m_fd, &msg, MSG_NOSIGNAL); while ((n < 0) && (errno == EINTR));
+  if (n < 0) IPC_REPORT("Failed to submit job: " << std::strerror(errno));
+
+  const char *rest = reinterpret_cast<const char *>(&req) + n;
+  if (!sendAll(m_fd, rest, sizeof(req) - size_t(n))) IPC_REPORT("Failed to submit job: " << std::strerror(errno));
+
+  return true;
+}
+
+
+bool Client::wait(Reply & reply)
+{
+  if (!recvAll(m_fd, &reply, sizeof(reply))) IPC_REPORT("Failed to receive reply from server");
+  return true;
+}
+
+} // End of ipc namespace
@@ -0,0 +1,140 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Protocol and client side of the local correlation server (see server.h).
+ * Jobs are submitted over a Unix domain socket as fixed size messages,
+ * the pixels never go through the socket: every frame lives in a sealed memfd,
+ * that is mapped by both the client and the server. The descriptor of the frame
+ * is passed with each request (SCM_RIGHTS), so the server never opens frames
+ * by name and the seals guarantee that the client cannot shrink the frame
+ * while the server accesses it.
+ * A frame holds the (w + 2) x (h + 2) input with a zero border
+ * followed by the w x h output.
+ */
+namespace ipc {
+
+const uint32_t MAGIC = 0x52524F43;      // "CORR"
+const char DEFAULT_SOCKET[] = "/tmp/corr_server.sock";
+
+const int MAX_NAME = 64;
+
+/** Job submitted by a client, the descriptor of its frame is attached to the message */
+struct Request
+{
+  uint32_t magic;
+  uint32_t job_id;              // vybera klient, server ho vrati v odpovedi
+  int32_t w;
+  int32_t h;
+  float mask[3 * 3];
+  char program[MAX_NAME];       // varianta kernelu, napr. corr_local_mem
+};
+
+enum Status { Ok = 0, ErrFrame = 1, ErrProgram = 2, ErrDevice = 3 };
+
+/** Reply sent by the server after the output of the job has been written to the frame */
+struct Reply
+{
+  uint32_t job_id;
+  int32_t status;
+  uint32_t batch_size;          // pocet uloh spracovanych v jednej davke s touto ulohou
+  uint32_t queue_depth;         // pocet cakajucich uloh v case vyberu davky
+  uint64_t queue_ns;            // cakanie vo fronte servera
+  uint64_t run_ns;              // od vyberu davky po zapis vystupu
+  uint64_t kernel_ns;           // cas kernelu na zariadeni
+};
+
+/** Size of a frame in bytes */
+inline size_t frameBytes(int w, int h)
+{
+  return sizeof(float) * (size_t(w + 2) * size_t(h + 2) + size_t(w) * size_t(h));
+}
+
+
+/**
+ * w x h frame in a memfd sealed against shrinking and growing.
+ * create() makes a new object (the name is only shown in /proc/<pid>/fd),
+ * open() maps an object received from another process.
+ */
+class Frame
+{
+  public:
+    Frame(void) { }
+    ~Frame(void) { close(); }
+
+    Frame(const Frame &) = delete;
+    Frame & operator=(const Frame &) = delete;
+
+    bool create(const char *name, int w, int h);
+    /** Maps the received descriptor fd, the frame takes ownership of it even on failure */
+    bool open(int fd, int w, int h);
+    void close(void);
+
+    /** Descriptor sent with the requests, -1 for an opened frame */
+    int fd(void) const { return m_fd; }
+
+    const std::string & name(void) const { return m_name; }
+    int width(void) const { return m_w; }
+    int height(void) const { return m_h; }
+
+    /** Input with a zero border, (w + 2) x (h + 2) pixels */
+    float *in(void) { return m_data; }
+    const float *in(void) const { return m_data; }
+
+    /** Output, w x h pixels */
+    float *out(void) { return m_data + size_t(m_w + 2) * size_t(m_h + 2); }
+    const float *out(void) const { return m_data + size_t(m_w + 2) * size_t(m_h + 2); }
+
+  private:
+    bool map(int fd);
+
+  private:
+    std::string m_name;
+    float *m_data = nullptr;
+    size_t m_size = 0;
+    int m_w = 0;
+    int m_h = 0;
+    int m_fd = -1;        // deskriptor vytvoreneho objektu, posiela sa s poziadavkami
+};
+
+
+/**
+ * Connection of a client to the server.
+ * Jobs may be pipelined, submit() does not wait for the result.
+ * The server answers the jobs of one connection in the order they were submitted.
+ */
+class Client
+{
+  public:
+    Client(void) { }
+    ~Client(void) { close(); }
+
+    Client(const Client &) = delete;
+    Client & operator=(const Client &) = delete;
+
+    bool connect(const char *socket_path = DEFAULT_SOCKET);
+    void close(void);
+
+    /** Submits correlation of frame with mask, the frame has to be created by this process, returns the id of the job */
+    bool submit(const Frame & frame, const float *mask, const char *program, uint32_t & job_id);
+
+    /** Waits for the reply to the oldest submitted job */
+    bool wait(Reply & reply);
+
+  private:
+    int m_fd = -1;
+    uint32_t m_next_id = 0;
+};
+
+
+/** Sends / receives exactly size bytes, returns false on error or closed connection */
+bool sendAll(int fd, const void *data, size_t size);
+bool recvAll(int fd, void *data, size_t size);
+
+} // End of ipc namespace
+
+#endif // IPC_H
@@ -1,10 +1,21 @@
 #include "input.h"
+#include "image_io.h"
+#include "box_filter.h"
+#include "trace.h"
+#include "validate.h"
+#include "server.h"
+#include "ocl_common.h"
 
 #include <QtOpenCL/qclcontext.h>
 #include <iostream>
 #include <iomanip>
 #include <cmath>
 #include <chrono>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <climits>
 
 #define IDX(x, y, size) ((x) + (size) * (y))
 
@@ -34,28 +45,43 @@ static void printArray2d(const float *p, int w, int h)
 }
 
 
-static float cmpArray2d(const float *p1, const float *p2, const int n)
+/**************************************** REFERENCNA C++ IMPLEMENTACIA ****************************************/
+
+static bool corrReference(const float *in, const float *mask, float *out, const int w, const int h)
 {
-  float sum = 0.0f;
+  const int in_row_pitch = w + 2;
 
-  for (int i = 0; i < n; ++i)
+  for (int j = 1; j <= h; ++j)
   {
-    sum += fabs(p1[i] - p2[i]);
+    for (int i = 1; i <= w; ++i)
+    {
+      float sum = 0.0f;
+
+      for (int jj = -1; jj <= 1; ++jj)
+      {
+        for (int ii = -1; ii <= 1; ++ii)
+        {
+          sum += in[IDX(i + ii, j + jj, in_row_pitch)] * mask[IDX(ii + 1, jj + 1, 3)];
+        }
+      }
+
+      out[IDX(i - 1, j - 1, w)] = sum;
+    }
   }
 
-  return (sum / float(n));
+  return true;
 }
 
 
-/**************************************** REFERENCNA C++ IMPLEMENTACIA ****************************************/
-
-static bool corrReference(const float *in, const float *mask, float *out, const int w, const int h)
+/** Referencna korelacia vyhodnotena iba v kazdom stride-tom pixeli, out ma velkost ceil(w / stride) x ceil(h / stride) */
+static bool corrReferenceStrided(const float *in, const float *mask, float *out, const int w, const int h, const int stride)
 {
   const int in_row_pitch = w + 2;
+  const int out_w = (w + stride - 1) / stride;
 
-  for (int j = 1; j <= h; ++j)
+  for (int j = 1; j <= h; j += stride)
   {
-    for (int i = 1; i <= w; ++i)
+    for (int i = 1; i <= w; i += stride)
     {
       float sum = 0.0f;
 
@@ -67,7 +93,7 @@ static bool corrReference(const float *in, const float *mask, float *out, const
         }
       }
 
-      out[IDX(i - 1, j - 1, w)] = sum;
+      out[IDX((i - 1) / stride, (j - 1) / stride, out_w)] = sum;
     }
   }
 
@@ -81,26 +107,39 @@ static bool corrOCLGlobalMem(const float *in, const float *mask, float *out, con
 {
   std::cout << "*** OpenCL kernel that uses only global memory ***" << std::endl;
 
+  trace::Span total(program_name);
+  trace::Span stage("create context");
+
   // Vytvorenie kontextu
   QCLContext ctx;
-  if (!ctx.create(QCLDevice::GPU)) OCL_REPORT("Failed to create OpenCL context");
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
   //if (!ctx.create(QCLDevice::CPU)) REPORT("Failed to create OpenCL context");
 
   // Vytvorenie fronty prikazov
   QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
   if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
   ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
+
+  stage.next("allocate and write buffers");
 
   // Alokacia pamate
-  QCLBuffer buf_in = ctx.createBufferCopy(in, sizeof(float) * (w + 2) * (h + 2), QCLBuffer::ReadWrite);
+  QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * (w + 2) * (h + 2), QCLBuffer::ReadWrite);
   if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
 
+  if (!traceTransfer("write input", buf_in.writeAsync(0, in, sizeof(float) * (w + 2) * (h + 2))))
+  {
+    OCL_REPORT("Failed to write data input buffer");
+  }
+
   QCLBuffer buf_mask = ctx.createBufferCopy(mask, sizeof(float) * 3 * 3, QCLBuffer::ReadWrite);
   if (buf_mask.isNull()) OCL_REPORT("Failed to create mask buffer");
 
   QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * w * h, QCLBuffer::ReadWrite);
   if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
 
+  stage.next("build program");
+
   // Skompilovanie programu a vytvorenie kernelu
   //QCLProgram program = ctx.buildProgramFromSourceFile(":/corr_global_mem.cl");
   QCLProgram program = ctx.buildProgramFromSourceFile(QString(":/%1.cl").arg(program_name));
@@ -118,14 +157,19 @@ static bool corrOCLGlobalMem(const float *in, const float *mask, float *out, con
 
   kernel.setGlobalWorkSize(w, h);
 
+  stage.next("run kernel");
+
   // Spustenie kernelu
   QCLEvent ev(kernel.run());
   ev.waitForFinished();
+  traceEvent(program_name, ev);
 
   std::cout << "Execution time of kernel: " << ((ev.finishTime() - ev.runTime()) * 1e-6) << " ms" << std::endl;
 
+  stage.next("read output");
+
   // Nacitanie vysledku
-  if (!buf_out.read(out, sizeof(float) * w * h)) OCL_REPORT("Failed to read output");
+  if (!traceTransfer("read output", buf_out.readAsync(0, out, sizeof(float) * w * h))) OCL_REPORT("Failed to read output");
 
   return true;
 }
@@ -136,21 +180,26 @@ static bool corrOCLLocalMem(const float *in, const float *mask, float *out, cons
   //std::cout << "*** OpenCL kernel that utilizes local memory " << ((use_v2) ? "second version ***" : "***") << std::endl;
   std::cout << "*** " << program_name << ((use_v2) ? " second version ***" : " ***") << std::endl;
 
+  trace::Span total(program_name);
+  trace::Span stage("create context");
+
   // Vytvorenie kontextu
   QCLContext ctx;
-  if (!ctx.create(QCLDevice::GPU)) OCL_REPORT("Failed to create OpenCL context");
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
   //if (!ctx.create(QCLDevice::CPU)) OCL_REPORT("Failed to create OpenCL context");
 
   // Vytvorenie fronty prikazov
   QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
   if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
   ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
 
   // Vypocet optimalnej local a global work_size
   int warp_size = 32; //64;
       // nastavenie workgroup-y (cize local work size)
   int block_width  = warp_size;                                                             // sirka work-groupy = local width/local_size(0)
-  int block_height = ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size;            // vyska work-groupy = local height/local_size(1)
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, warp_size); // vyska work-groupy = local height/local_size(1)
+  while ((warp_size % block_height) != 0) --block_height;                                   // work-groupa nesmie byt vyssia ako tile (pocl hlasi az 4096 work-itemov)
       // nastavenie tilu (bloku po ktorom sa budu spracovavat data)
   int tile_width = warp_size;
   int tile_height = use_v2 ? block_height : warp_size;
@@ -171,13 +220,15 @@ static bool corrOCLLocalMem(const float *in, const float *mask, float *out, cons
             << ", out_w=" << out_w << ", out_h=" << out_h
             << std::endl;
 
+  stage.next("allocate and write buffers");
+
   QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * in_w * in_h, QCLBuffer::ReadWrite);
   if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
 
-  if (!buf_in.writeRect(QRect(0, 0, (w + 2) * sizeof(float), (h + 2)),
-                        in,
-                        in_w * sizeof(float),
-                        (w + 2) * sizeof(float)))
+  if (!traceTransfer("write input", buf_in.writeRectAsync(QRect(0, 0, (w + 2) * sizeof(float), (h + 2)),
+                                                          in,
+                                                          in_w * sizeof(float),
+                                                          (w + 2) * sizeof(float))))
   {
     OCL_REPORT("Failed to write data input buffer");
   }
@@ -188,6 +239,8 @@ static bool corrOCLLocalMem(const float *in, const float *mask, float *out, cons
   QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * out_w * out_h, QCLBuffer::ReadWrite);
   if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
 
+  stage.next("build program");
+
   // Skompilovanie programu a vytvorenie kernelu
   QString opts("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4");
   //QString opts("-DSTR=\\\"test\\\"");
@@ -212,17 +265,152 @@ static bool corrOCLLocalMem(const float *in, const float *mask, float *out, cons
   kernel.setLocalWorkSize(block_width, block_height);
   kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
 
+  stage.next("run kernel");
+
+  // Spustenie kernelu
+  QCLEvent ev(kernel.run());
+  ev.waitForFinished();
+  traceEvent(program_name, ev);
+
+  std::cout << "Execution time of kernel: " << ((ev.finishTime() - ev.runTime()) * 1e-6) << " ms" << std::endl;
+
+  stage.next("read output");
+
+  // Nacitanie vysledku
+  if (!traceTransfer("read output", buf_out.readRectAsync(QRect(0, 0, w * sizeof(float), h),
+                                                          out,
+                                                          sizeof(float) * out_w,
+                                                          sizeof(float) * w)))
+  {
+    OCL_REPORT("Failed to read output");
+  }
+
+  return true;
+}
+
+
+static bool corrOCLLocalMemShuffle(const float *in, const float *mask, float *out, const int w, const int h, const char *program_name, bool /* dummy */)
+{
+  std::cout << "*** " << program_name << " ***" << std::endl;
+
+  trace::Span total(program_name);
+  trace::Span stage("create context");
+
+  // Vytvorenie kontextu
+  QCLContext ctx;
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
+
+  // Kontrola podpory sub-group shuffle, inak sa pouzije verzia s lokalnou pamatou
+  QCLDevice dev = ctx.defaultDevice();
+  QString shuffle_opt;
+  if (dev.hasExtension("cl_khr_subgroups") && dev.hasExtension("cl_khr_subgroup_shuffle"))
+  {
+    shuffle_opt = "";
+  }
+  else if (dev.hasExtension("cl_intel_subgroups"))
+  {
+    shuffle_opt = " -DUSE_INTEL_SUBGROUPS";
+  }
+  else
+  {
+    std::cerr << "Sub-group shuffle is not supported by the device, falling back to corr_local_mem" << std::endl;
+    return corrOCLLocalMem(in, mask, out, w, h, "corr_local_mem");
+  }
+
+  // Vytvorenie fronty prikazov
+  QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
+  if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
+  ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
+
+  // Vypocet optimalnej local a global work_size
+  int warp_size = 32; //64;
+      // nastavenie tilu (bloku po ktorom sa budu spracovavat data)
+  int tile_width = warp_size;
+  int tile_height = warp_size;
+      // nastavenie workgroup-y (cize local work size)
+  int block_width  = warp_size;                                                             // sirka work-groupy = local width/local_size(0)
+  int block_height = std::min(dev.maximumWorkItemsPerGroup() / warp_size, tile_height);    // vyska work-groupy = local height/local_size(1)
+  while ((tile_height % block_height) != 0) --block_height;                                 // kazdy work-item spracuje rovnako vysoky pas riadkov
+      // nastavenie gridu (pocet tilov na vysku a sirku)
+  int grid_width  = (w + tile_width  - 1) / tile_width;     // pocet tilov na sirku
+  int grid_height = (h + tile_height - 1) / tile_height;    // pocet tilov na vysku
+
+  // Alokacia pamate
+  int in_w  = grid_width  * tile_width + 2;
+  int in_h  = grid_height * tile_height + 2;
+  int out_w = grid_width  * tile_width;
+  int out_h = grid_height * tile_height;
+
+  std::cerr << "grid_width=" << grid_width << ", grid_height=" << grid_height
+            << ", block_width=" << block_width << ", block_height=" << block_height
+            << ", tile_width=" << tile_width << ", tile_height=" << tile_height
+            << ", in_w=" << in_w << ", in_h=" << in_h
+            << ", out_w=" << out_w << ", out_h=" << out_h
+            << std::endl;
+
+  stage.next("allocate and write buffers");
+
+  QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * in_w * in_h, QCLBuffer::ReadWrite);
+  if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
+
+  if (!traceTransfer("write input", buf_in.writeRectAsync(QRect(0, 0, (w + 2) * sizeof(float), (h + 2)),
+                                                          in,
+                                                          in_w * sizeof(float),
+                                                          (w + 2) * sizeof(float))))
+  {
+    OCL_REPORT("Failed to write data input buffer");
+  }
+
+  QCLBuffer buf_mask = ctx.createBufferCopy(mask, sizeof(float) * 3 * 3, QCLBuffer::ReadWrite);
+  if (buf_mask.isNull()) OCL_REPORT("Failed to create mask buffer");
+
+  QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * out_w * out_h, QCLBuffer::ReadWrite);
+  if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
+
+  stage.next("build program");
+
+  // Skompilovanie programu a vytvorenie kernelu
+  QString opts("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4");
+  QCLProgram program = ctx.buildProgramFromSourceFile(QString(":/%1.cl").arg(program_name),
+                                                      opts.arg(tile_width).arg(tile_height)
+                                                          .arg(block_width).arg(block_height) + shuffle_opt);
+  if (program.isNull())
+  {
+    std::cerr << "Failed to compile sub-group shuffle program, falling back to corr_local_mem" << std::endl;
+    return corrOCLLocalMem(in, mask, out, w, h, "corr_local_mem");
+  }
+
+  QCLKernel kernel = program.createKernel("corr");
+  if (kernel.isNull()) OCL_REPORT("Failed to create kernel");
+
+  // Nastavenie parametrov kernelu
+  kernel.setArg(0, buf_in);
+  kernel.setArg(1, buf_mask);
+  kernel.setArg(2, buf_out);
+  kernel.setArg(3, in_w);
+  kernel.setArg(4, out_w);
+
+  // Nastavenie work size-ov
+  kernel.setLocalWorkSize(block_width, block_height);
+  kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
+
+  stage.next("run kernel");
+
   // Spustenie kernelu
   QCLEvent ev(kernel.run());
   ev.waitForFinished();
+  traceEvent(program_name, ev);
 
   std::cout << "Execution time of kernel: " << ((ev.finishTime() - ev.runTime()) * 1e-6) << " ms" << std::endl;
 
+  stage.next("read output");
+
   // Nacitanie vysledku
-  if (!buf_out.readRect(QRect(0, 0, w * sizeof(float), h),
-                        out,
-                        sizeof(float) * out_w,
-                        sizeof(float) * w))
+  if (!traceTransfer("read output", buf_out.readRectAsync(QRect(0, 0, w * sizeof(float), h),
+                                                          out,
+                                                          sizeof(float) * out_w,
+                                                          sizeof(float) * w)))
   {
     OCL_REPORT("Failed to read output");
   }
@@ -235,21 +423,26 @@ static bool corrOCLLocalMemInner(const float *in, const float *mask, float *out,
 {
   std::cout << "*** " << program_name << ((use_v2) ? " second version ***" : " ***") << std::endl;
 
+  trace::Span total(program_name);
+  trace::Span stage("create context");
+
   // Vytvorenie kontextu
   QCLContext ctx;
-  if (!ctx.create(QCLDevice::GPU)) OCL_REPORT("Failed to create OpenCL context");
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
   //if (!ctx.create(QCLDevice::CPU)) OCL_REPORT("Failed to create OpenCL context");
 
   // Vytvorenie fronty prikazov
   QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
   if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
   ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
 
   // Vypocet optimalnej local a global work_size
   int warp_size = 32; //64;
       // nastavenie workgroup-y (cize local work size)
   int block_width  = warp_size;                                                             // sirka work-groupy = local width/local_size(0)
-  int block_height = ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size;            // vyska work-groupy = local height/local_size(1)
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, warp_size); // vyska work-groupy = local height/local_size(1)
+      // vstupny tile ma rozmery work-groupy, takze aj on je najviac warp_size x warp_size
       // nastavenie velkosti vystupneho tilu
   int tile_width = block_width - 2; // -2 pretoze mam korelacnu masku o velkosti 3 a polomere 1
   int tile_height = block_height - 2;
@@ -270,13 +463,15 @@ static bool corrOCLLocalMemInner(const float *in, const float *mask, float *out,
             << ", out_w=" << out_w << ", out_h=" << out_h
             << std::endl;
 
+  stage.next("allocate and write buffers");
+
   QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * in_w * in_h, QCLBuffer::ReadWrite);
   if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
 
-  if (!buf_in.writeRect(QRect(0, 0, (w + 2) * sizeof(float), (h + 2)),
-                        in,
-                        in_w * sizeof(float),
-                        (w + 2) * sizeof(float)))
+  if (!traceTransfer("write input", buf_in.writeRectAsync(QRect(0, 0, (w + 2) * sizeof(float), (h + 2)),
+                                                          in,
+                                                          in_w * sizeof(float),
+                                                          (w + 2) * sizeof(float))))
   {
     OCL_REPORT("Failed to write data input buffer");
   }
@@ -287,6 +482,8 @@ static bool corrOCLLocalMemInner(const float *in, const float *mask, float *out,
   QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * out_w * out_h, QCLBuffer::ReadWrite);
   if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
 
+  stage.next("build program");
+
   // Skompilovanie programu a vytvorenie kernelu
   QString opts("-DIN_TILE_W=%1 -DIN_TILE_H=%2 -DOUT_TILE_W=%3 -DOUT_TILE_H=%4");
   QCLProgram program = ctx.buildProgramFromSourceFile(QString(":/%1%2").arg(program_name).arg(use_v2 ? "_v2.cl" : ".cl"),
@@ -308,17 +505,22 @@ static bool corrOCLLocalMemInner(const float *in, const float *mask, float *out,
   kernel.setLocalWorkSize(block_width, block_height);
   kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
 
+  stage.next("run kernel");
+
   // Spustenie kernelu
   QCLEvent ev(kernel.run());
   ev.waitForFinished();
+  traceEvent(program_name, ev);
 
   std::cout << "Execution time of kernel: " << ((ev.finishTime() - ev.runTime()) * 1e-6) << " ms" << std::endl;
 
+  stage.next("read output");
+
   // Nacitanie vysledku
-  if (!buf_out.readRect(QRect(0, 0, w * sizeof(float), h),
-                        out,
-                        sizeof(float) * out_w,
-                        sizeof(float) * w))
+  if (!traceTransfer("read output", buf_out.readRectAsync(QRect(0, 0, w * sizeof(float), h),
+                                                          out,
+                                                          sizeof(float) * out_w,
+                                                          sizeof(float) * w)))
   {
     OCL_REPORT("Failed to read output");
   }
@@ -332,21 +534,26 @@ static bool corrOCLLocalMemPadding(const float *in, const float *mask, float *ou
   //std::cout << "*** OpenCL kernel that utilizes local memory and aligns global data " << ((use_v2) ? "second version ***" : "***") << std::endl;
   std::cout << "*** " << program_name << ((use_v2) ? " second version ***" : " ***") << std::endl;
 
+  trace::Span total(program_name);
+  trace::Span stage("create context");
+
   // Vytvorenie kontextu
   QCLContext ctx;
-  if (!ctx.create(QCLDevice::GPU)) OCL_REPORT("Failed to create OpenCL context");
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
   //if (!ctx.create(QCLDevice::CPU)) OCL_REPORT("Failed to create OpenCL context");
 
   // Vytvorenie fronty prikazov
   QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
   if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
   ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
 
   // Vypocet optimalnej local a global work_size
   int warp_size = 32; //64;
       // nastavenie workgroup-y (cize local work size)
   int block_width  = warp_size;                                                             // sirka work-groupy = local width/local_size(0)
-  int block_height = ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size;            // vyska work-groupy = local height/local_size(1)
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, warp_size); // vyska work-groupy = local height/local_size(1)
+  while ((warp_size % block_height) != 0) --block_height;                                   // work-groupa nesmie byt vyssia ako tile (pocl hlasi az 4096 work-itemov)
       // nastavenie tilu (bloku po ktorom sa budu spracovavat data)
   int tile_width = warp_size;
   int tile_height = use_v2 ? block_height : warp_size;
@@ -380,13 +587,15 @@ static bool corrOCLLocalMemPadding(const float *in, const float *mask, float *ou
             << ", alignment=" << alignment << ", padding_in=" << padding_in << ", padding_out=" << padding_out
             << std::endl;
 
+  stage.next("allocate and write buffers");
+
   QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * in_w * in_h, QCLBuffer::ReadWrite);
   if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
 
-  if (!buf_in.writeRect(QRect((alignment - 1) * sizeof(float), 0, (w + 2) * sizeof(float), (h + 2)),
-                        in,
-                        in_w * sizeof(float),
-                        (w + 2) * sizeof(float)))
+  if (!traceTransfer("write input", buf_in.writeRectAsync(QRect((alignment - 1) * sizeof(float), 0, (w + 2) * sizeof(float), (h + 2)),
+                                                          in,
+                                                          in_w * sizeof(float),
+                                                          (w + 2) * sizeof(float))))
   {
     OCL_REPORT("Failed to write data input buffer");
   }
@@ -397,6 +606,8 @@ static bool corrOCLLocalMemPadding(const float *in, const float *mask, float *ou
   QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * out_w * out_h, QCLBuffer::ReadWrite);
   if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
 
+  stage.next("build program");
+
   // Skompilovanie programu a vytvorenie kernelu
   QString opts("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4 -DPADDING=%5");
   //QCLProgram program = ctx.buildProgramFromSourceFile(use_v2 ? ":/corr_local_mem_v2_padding.cl" : ":/corr_local_mem_padding.cl",
@@ -420,17 +631,22 @@ static bool corrOCLLocalMemPadding(const float *in, const float *mask, float *ou
   kernel.setLocalWorkSize(block_width, block_height);
   kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
 
+  stage.next("run kernel");
+
   // Spustenie kernelu
   QCLEvent ev(kernel.run());
   ev.waitForFinished();
+  traceEvent(program_name, ev);
 
   std::cout << "Execution time of kernel: " << ((ev.finishTime() - ev.runTime()) * 1e-6) << " ms" << std::endl;
 
+  stage.next("read output");
+
   // Nacitanie vysledku
-  if (!buf_out.readRect(QRect(0, 0, w * sizeof(float), h),
-                        out,
-                        sizeof(float) * out_w,
-                        sizeof(float) * w))
+  if (!traceTransfer("read output", buf_out.readRectAsync(QRect(0, 0, w * sizeof(float), h),
+                                                          out,
+                                                          sizeof(float) * out_w,
+                                                          sizeof(float) * w)))
   {
     OCL_REPORT("Failed to read output");
   }
@@ -444,21 +660,26 @@ static bool corrOCLImage(const float *in, const float *mask, float *out, const i
   //std::cout << "*** OpenCL kernel that uses textures ***" << std::endl;
   std::cout << "*** " << program_name << ((use_v2) ? " second version ***" : " ***") << std::endl;
 
+  trace::Span total(program_name);
+  trace::Span stage("create context");
+
   // Vytvorenie kontextu
   QCLContext ctx;
-  if (!ctx.create(QCLDevice::GPU)) OCL_REPORT("Failed to create OpenCL context");
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
   //if (!ctx.create(QCLDevice::CPU)) OCL_REPORT("Failed to create OpenCL context");
 
   // Vytvorenie fronty prikazov
   QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
   if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
   ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
 
   // Vypocet optimalnej local a global work_size
   int warp_size = 32; //64;
       // nastavenie workgroup-y (cize local work size)
   int block_width  = warp_size;                                                             // sirka work-groupy = local width/local_size(0)
-  int block_height = ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size;            // vyska work-groupy = local height/local_size(1)
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, warp_size); // vyska work-groupy = local height/local_size(1)
+  while ((warp_size % block_height) != 0) --block_height;                                   // work-groupa nesmie byt vyssia ako tile (pocl hlasi az 4096 work-itemov)
       // nastavenie tilu (bloku po ktorom sa budu spracovavat data)
   int tile_width = warp_size;
   int tile_height = use_v2 ? block_height : warp_size;
@@ -477,11 +698,15 @@ static bool corrOCLImage(const float *in, const float *mask, float *out, const i
             << ", out_w=" << out_w << ", out_h=" << out_h
             << std::endl;
 
+  stage.next("allocate buffers");
+
   // Alokacia pamate
   QCLImageFormat fmt(QCLImageFormat::Order_R, QCLImageFormat::Type_Float);
   QCLImage2D img_in = ctx.createImage2DDevice(fmt, QSize(w, h), QCLBuffer::ReadOnly);
   if (img_in.isNull()) OCL_REPORT("Failed to create input GPU image");
 
+  stage.next("map input image");
+
   float *ptr = (float *) img_in.map(QRect(0, 0, w, h), QCLImage2D::WriteOnly);
   if (ptr == nullptr) OCL_REPORT("Failed to map input GPU image");
 
@@ -495,12 +720,16 @@ static bool corrOCLImage(const float *in, const float *mask, float *out, const i
 
   img_in.unmap(ptr);
 
+  stage.next("allocate buffers");
+
   QCLBuffer buf_mask = ctx.createBufferCopy(mask, sizeof(float) * 3 * 3, QCLBuffer::ReadWrite);
   if (buf_mask.isNull()) OCL_REPORT("Failed to create mask buffer");
 
   QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * out_w * out_h, QCLBuffer::ReadWrite);
   if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
 
+  stage.next("build program");
+
   // Skompilovanie programu a vytvorenie kernelu
   QString opts("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4");
 
@@ -522,17 +751,22 @@ static bool corrOCLImage(const float *in, const float *mask, float *out, const i
   kernel.setLocalWorkSize(block_width, block_height);
   kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
 
+  stage.next("run kernel");
+
   // Spustenie kernelu
   QCLEvent ev(kernel.run());
   ev.waitForFinished();
+  traceEvent(program_name, ev);
 
   std::cout << "Execution time of kernel: " << ((ev.finishTime() - ev.runTime()) * 1e-6) << " ms" << std::endl;
 
+  stage.next("read output");
+
   // Nacitanie vysledku
-  if (!buf_out.readRect(QRect(0, 0, w * sizeof(float), h),
-                        out,
-                        sizeof(float) * out_w,
-                        sizeof(float) * w))
+  if (!traceTransfer("read output", buf_out.readRectAsync(QRect(0, 0, w * sizeof(float), h),
+                                                          out,
+                                                          sizeof(float) * out_w,
+                                                          sizeof(float) * w)))
   {
     OCL_REPORT("Failed to read output");
   }
@@ -541,99 +775,860 @@ static bool corrOCLImage(const float *in, const float *mask, float *out, const i
 }
 
 
-/**************************************** SPUSTANIE TESTOV ****************************************/
-
-//typedef bool (* TCorrFunc)(const float *in, const float *mask, float *out, const int w, const int h, bool use_v2);
-typedef bool (* TCorrFunc)(const float *in, const float *mask, float *out, const int w, const int h, const char *program_name, bool use_v2);
-
-//static bool testFunc(TCorrFunc f, const float *ref, const float *in, const float *mask, float *out, const int w, const int h, bool use_v2)
-static bool testFunc(TCorrFunc f, const float *ref, const float *in, const float *mask, float *out, const int w, const int h, const char *program_name, bool use_v2)
+static bool corrOCLLocalMemRadius(const float *in, const float *mask, float *out, const int w, const int h, const int radius, double & kernel_ms)
 {
-  //if (!f(in, mask, out, w, h, use_v2)) return false;
-  if (!f(in, mask, out, w, h, program_name, use_v2)) return false;
+  std::cout << "*** corr_local_mem_radius (radius " << radius << ") ***" << std::endl;
 
-#ifdef DEBUG
-  std::cout << "C++:" << std::endl;    printArray2d(ref, w, h); std::cout << std::endl;
-  std::cout << "OpenCL:" << std::endl; printArray2d(out, w, h); std::cout << std::endl;
-#endif
+  const int mask_w = 2 * radius + 1;
 
-  std::cout << "Average difference between elements of arrays: " << cmpArray2d(ref, out, w * h) << std::endl;
+  trace::Span total("corr_local_mem_radius");
+  trace::Span stage("create context");
 
-  return true;
-}
+  // Vytvorenie kontextu
+  QCLContext ctx;
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
 
+  // Vytvorenie fronty prikazov
+  QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
+  if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
+  ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
 
-static bool runTestDebug(void)
-{
-  // Vygenerovanie testovacich dat
-  const int mask_w = 3;
-  const float mask[mask_w * mask_w] = {
-    1, 1, 1,
-    1, 1, 1,
-    1, 1, 1
-  };
+  // Vypocet optimalnej local a global work_size
+  int warp_size = 32; //64;
+  int tile_width = warp_size;
+  int tile_height = warp_size;
+  int block_width  = warp_size;
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, tile_height);
+  while ((tile_height % block_height) != 0) --block_height;
+  int grid_width  = (w + tile_width  - 1) / tile_width;
+  int grid_height = (h + tile_height - 1) / tile_height;
 
-  int w = 40, h = 40;
-  //int w = 10, h = 10;
-  const float *in;
-  float *out_cpp, *out_ocl;
+  // Alokacia pamate
+  int in_w  = grid_width  * tile_width + 2 * radius;
+  int in_h  = grid_height * tile_height + 2 * radius;
+  int out_w = grid_width  * tile_width;
+  int out_h = grid_height * tile_height;
 
-  input::genSequential(in, out_cpp, out_ocl, w, h, mask_w / 2);
-  std::cout << "Input:" << std::endl;    printArray2d(in, w + 2, h + 2); std::cout << std::endl;
-  if (!corrReference(in, mask, out_cpp, w, h)) return false;
-  //if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, true)) return false;
-  //if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, w, h, false)) return false;
-  //if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_padding", true)) return false;
-  //if (!testFunc(corrOCLImage, out_cpp, in, mask, out_ocl, w, h, "corr_image", false)) return false;
-  if (!testFunc(corrOCLLocalMemInner, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_inner_tile", false)) return false;
+  std::cerr << "grid_width=" << grid_width << ", grid_height=" << grid_height
+            << ", block_width=" << block_width << ", block_height=" << block_height
+            << ", tile_width=" << tile_width << ", tile_height=" << tile_height
+            << ", in_w=" << in_w << ", in_h=" << in_h
+            << ", out_w=" << out_w << ", out_h=" << out_h
+            << std::endl;
 
-  delete [] in;
-  delete [] out_cpp;
-  delete [] out_ocl;
+  stage.next("allocate and write buffers");
 
-  return true;
-}
+  QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * in_w * in_h, QCLBuffer::ReadWrite);
+  if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
 
-static bool runTest1(void)
-{
-  // Vygenerovanie testovacich dat
-  const int mask_w = 3;
-  const float mask[mask_w * mask_w] = {
-    1, 1, 1,
-    1, 1, 1,
-    1, 1, 1
-  };
+  if (!traceTransfer("write input", buf_in.writeRectAsync(QRect(0, 0, (w + 2 * radius) * sizeof(float), (h + 2 * radius)),
+                                                          in,
+                                                          in_w * sizeof(float),
+                                                          (w + 2 * radius) * sizeof(float))))
+  {
+    OCL_REPORT("Failed to write data input buffer");
+  }
 
-  int w = 10000, h = 10000;
-  const float *in;
-  float *out_cpp, *out_ocl;
+  QCLBuffer buf_mask = ctx.createBufferCopy(mask, sizeof(float) * mask_w * mask_w, QCLBuffer::ReadWrite);
+  if (buf_mask.isNull()) OCL_REPORT("Failed to create mask buffer");
 
-#ifdef DEBUG
-  input::genDebug(in, out_cpp, out_ocl, w, h);
-#else
-  input::genSequential(in, out_cpp, out_ocl, w, h, mask_w / 2);
-#endif
+  QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * out_w * out_h, QCLBuffer::ReadWrite);
+  if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
 
-  std::cout << "Test size: w=" << w << ", h=" << h << std::endl;
+  stage.next("build program");
 
-  // vypocet referencnej implementacie
-  if (!corrReference(in, mask, out_cpp, w, h)) return false;
+  // Skompilovanie programu a vytvorenie kernelu
+  QString opts("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4 -DRADIUS=%5");
+  QCLProgram program = ctx.buildProgramFromSourceFile(":/corr_local_mem_radius.cl",
+                                                      opts.arg(tile_width).arg(tile_height)
+                                                          .arg(block_width).arg(block_height)
+                                                          .arg(radius));
+  if (program.isNull()) OCL_REPORT("Failed to compile program");
 
-  // OpenCL implementacia
-  if (!testFunc(corrOCLGlobalMem, out_cpp, in, mask, out_ocl, w, h, "corr_global_mem", false)) return false;
-  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem", false)) return false;
-  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem", true)) return false;
-  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_corners", false)) return false;
-  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_right_border", false)) return false;
-  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_right_border_2", false)) return false;
-  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_rows_joint", false)) return false;
-  //if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_float4", false)) return false;
-  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_indexing", false)) return false;
-  if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_padding", false)) return false;
-  if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_padding", true)) return false;
-  if (!testFunc(corrOCLImage, out_cpp, in, mask, out_ocl, w, h, "corr_image", false)) return false;
-  if (!testFunc(corrOCLImage, out_cpp, in, mask, out_ocl, w, h, "corr_image", true)) return false;
-  if (!testFunc(corrOCLLocalMemInner, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_inner_tile", false)) return false;
+  QCLKernel kernel = program.createKernel("corr");
+  if (kernel.isNull()) OCL_REPORT("Failed to create kernel");
+
+  // Nastavenie parametrov kernelu
+  kernel.setArg(0, buf_in);
+  kernel.setArg(1, buf_mask);
+  kernel.setArg(2, buf_out);
+  kernel.setArg(3, in_w);
+  kernel.setArg(4, out_w);
+
+  // Nastavenie work size-ov
+  kernel.setLocalWorkSize(block_width, block_height);
+  kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
+
+  stage.next("run kernel");
+
+  // Spustenie kernelu
+  QCLEvent ev(kernel.run());
+  ev.waitForFinished();
+  traceEvent("corr_local_mem_radius", ev);
+
+  kernel_ms = (ev.finishTime() - ev.runTime()) * 1e-6;
+  std::cout << "Execution time of kernel: " << kernel_ms << " ms" << std::endl;
+
+  stage.next("read output");
+
+  // Nacitanie vysledku
+  if (!traceTransfer("read output", buf_out.readRectAsync(QRect(0, 0, w * sizeof(float), h),
+                                                          out,
+                                                          sizeof(float) * out_w,
+                                                          sizeof(float) * w)))
+  {
+    OCL_REPORT("Failed to read output");
+  }
+
+  return true;
+}
+
+
+/**
+ * Correlation with a constant mask is a scaled box filter, which is computed
+ * with running sums in two passes (corr_box.cl) in time independent of the radius.
+ * Masks that are not constant are processed by the generic corr_local_mem_radius kernel.
+ */
+static bool corrOCLBox(const float *in, const float *mask, float *out, const int w, const int h, const int radius, double & kernel_ms)
+{
+  float value = 0.0f;
+  if (!box_filter::isConstMask(mask, 2 * radius + 1, value))
+  {
+    return corrOCLLocalMemRadius(in, mask, out, w, h, radius, kernel_ms);
+  }
+
+  std::cout << "*** corr_box (radius " << radius << ") ***" << std::endl;
+
+  trace::Span total("corr_box");
+  trace::Span stage("create context");
+
+  // Vytvorenie kontextu
+  QCLContext ctx;
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
+
+  // Vytvorenie fronty prikazov
+  QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
+  if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
+  ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
+
+  // kazdy work-item spracuje seg_len pixelov riadku/stlpca, pociatocna suma 2 * radius pixelov
+  // sa rozlozi na seg_len pixelov, takze praca na pixel (seg_len + 2 * radius) / seg_len je najviac 1.25
+  int seg_len = std::max(32, 8 * radius);
+  int in_w = w + 2 * radius;
+  int in_h = h + 2 * radius;
+
+  stage.next("allocate and write buffers");
+
+  // Alokacia pamate
+  QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * in_w * in_h, QCLBuffer::ReadOnly);
+  if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
+
+  if (!traceTransfer("write input", buf_in.writeAsync(0, in, sizeof(float) * in_w * in_h)))
+  {
+    OCL_REPORT("Failed to write data input buffer");
+  }
+
+  QCLBuffer buf_tmp = ctx.createBufferDevice(sizeof(float) * w * in_h, QCLBuffer::ReadWrite);
+  if (buf_tmp.isNull()) OCL_REPORT("Failed to create temporary buffer");
+
+  QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * w * h, QCLBuffer::WriteOnly);
+  if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
+
+  stage.next("build program");
+
+  // Skompilovanie programu a vytvorenie kernelov
+  QString opts("-DRADIUS=%1 -DSEG=%2");
+  QCLProgram program = ctx.buildProgramFromSourceFile(":/corr_box.cl", opts.arg(radius).arg(seg_len));
+  if (program.isNull()) OCL_REPORT("Failed to compile program");
+
+  QCLKernel kernel_rows = program.createKernel("box_rows");
+  if (kernel_rows.isNull()) OCL_REPORT("Failed to create kernel");
+
+  QCLKernel kernel_cols = program.createKernel("box_cols");
+  if (kernel_cols.isNull()) OCL_REPORT("Failed to create kernel");
+
+  // Nastavenie parametrov kernelov
+  kernel_rows.setArg(0, buf_in);
+  kernel_rows.setArg(1, buf_tmp);
+  kernel_rows.setArg(2, in_w);
+  kernel_rows.setArg(3, w);
+  kernel_rows.setArg(4, in_h);
+  kernel_rows.setGlobalWorkSize((w + seg_len - 1) / seg_len, in_h);
+
+  kernel_cols.setArg(0, buf_tmp);
+  kernel_cols.setArg(1, buf_out);
+  kernel_cols.setArg(2, value);
+  kernel_cols.setArg(3, w);
+  kernel_cols.setArg(4, h);
+  kernel_cols.setArg(5, w);
+  kernel_cols.setGlobalWorkSize(w, (h + seg_len - 1) / seg_len);
+
+  stage.next("run kernels");
+
+  // Spustenie kernelov
+  QCLEvent ev_rows(kernel_rows.run());
+  QCLEvent ev_cols(kernel_cols.run());
+  ev_cols.waitForFinished();
+  traceEvent("box_rows", ev_rows);
+  traceEvent("box_cols", ev_cols);
+
+  kernel_ms = ((ev_rows.finishTime() - ev_rows.runTime()) + (ev_cols.finishTime() - ev_cols.runTime())) * 1e-6;
+  std::cout << "Execution time of kernels: " << kernel_ms << " ms" << std::endl;
+
+  stage.next("read output");
+
+  // Nacitanie vysledku
+  if (!traceTransfer("read output", buf_out.readAsync(0, out, sizeof(float) * w * h))) OCL_REPORT("Failed to read output");
+
+  return true;
+}
+
+
+/**
+ * Computes the size of the decimated output and of the input buffer,
+ * that covers the input footprint of all tiles of the strided kernel.
+ */
+static void stridedGeometry(const int w, const int h, const int stride, const int tile_width, const int tile_height,
+                            int & out_w, int & out_h, int & grid_width, int & grid_height, int & in_w, int & in_h)
+{
+  out_w = (w + stride - 1) / stride;
+  out_h = (h + stride - 1) / stride;
+  grid_width  = (out_w + tile_width  - 1) / tile_width;      // pocet tilov na sirku
+  grid_height = (out_h + tile_height - 1) / tile_height;     // pocet tilov na vysku
+  in_w = std::max(w + 2, (grid_width  * tile_width  - 1) * stride + 3);
+  in_h = std::max(h + 2, (grid_height * tile_height - 1) * stride + 3);
+}
+
+
+static bool corrOCLLocalMemStrided(const float *in, const float *mask, float *out, const int w, const int h, const int stride, double & kernel_ms)
+{
+  std::cout << "*** corr_local_mem_strided (stride " << stride << ") ***" << std::endl;
+
+  trace::Span total("corr_local_mem_strided");
+  trace::Span stage("create context");
+
+  // Vytvorenie kontextu
+  QCLContext ctx;
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
+
+  // Vytvorenie fronty prikazov
+  QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
+  if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
+  ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
+
+  // Vypocet optimalnej local a global work_size
+  int warp_size = 32; //64;
+      // nastavenie workgroup-y (cize local work size)
+  int block_width  = warp_size;
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, 8);
+      // nastavenie tilu, vstupna oblast tilu rastie so stride, preto ma tile vysku work-groupy
+  int tile_width = warp_size;
+  int tile_height = block_height;
+
+  int out_w, out_h, grid_width, grid_height, in_w, in_h;
+  stridedGeometry(w, h, stride, tile_width, tile_height, out_w, out_h, grid_width, grid_height, in_w, in_h);
+
+  std::cerr << "grid_width=" << grid_width << ", grid_height=" << grid_height
+            << ", block_width=" << block_width << ", block_height=" << block_height
+            << ", tile_width=" << tile_width << ", tile_height=" << tile_height
+            << ", in_w=" << in_w << ", in_h=" << in_h
+            << ", out_w=" << out_w << ", out_h=" << out_h
+            << std::endl;
+
+  stage.next("allocate and write buffers");
+
+  // Alokacia pamate
+  QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * in_w * in_h, QCLBuffer::ReadWrite);
+  if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
+
+  if (!traceTransfer("write input", buf_in.writeRectAsync(QRect(0, 0, (w + 2) * sizeof(float), (h + 2)),
+                                                          in,
+                                                          in_w * sizeof(float),
+                                                          (w + 2) * sizeof(float))))
+  {
+    OCL_REPORT("Failed to write data input buffer");
+  }
+
+  QCLBuffer buf_mask = ctx.createBufferCopy(mask, sizeof(float) * 3 * 3, QCLBuffer::ReadWrite);
+  if (buf_mask.isNull()) OCL_REPORT("Failed to create mask buffer");
+
+  // vystup obsahuje iba decimovane pixely
+  QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * out_w * out_h, QCLBuffer::ReadWrite);
+  if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
+
+  stage.next("build program");
+
+  // Skompilovanie programu a vytvorenie kernelu
+  QString opts("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4 -DSTRIDE=%5");
+  QCLProgram program = ctx.buildProgramFromSourceFile(":/corr_local_mem_strided.cl",
+                                                      opts.arg(tile_width).arg(tile_height)
+                                                          .arg(block_width).arg(block_height)
+                                                          .arg(stride));
+  if (program.isNull()) OCL_REPORT("Failed to compile program");
+
+  QCLKernel kernel = program.createKernel("corr");
+  if (kernel.isNull()) OCL_REPORT("Failed to create kernel");
+
+  // Nastavenie parametrov kernelu
+  kernel.setArg(0, buf_in);
+  kernel.setArg(1, buf_mask);
+  kernel.setArg(2, buf_out);
+  kernel.setArg(3, in_w);
+  kernel.setArg(4, out_w);
+  kernel.setArg(5, 0);
+  kernel.setArg(6, out_w);
+  kernel.setArg(7, out_h);
+
+  // Nastavenie work size-ov
+  kernel.setLocalWorkSize(block_width, block_height);
+  kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
+
+  stage.next("run kernel");
+
+  // Spustenie kernelu
+  QCLEvent ev(kernel.run());
+  ev.waitForFinished();
+  traceEvent("corr_local_mem_strided", ev);
+
+  kernel_ms = (ev.finishTime() - ev.runTime()) * 1e-6;
+  std::cout << "Execution time of kernel: " << kernel_ms << " ms" << std::endl;
+
+  stage.next("read output");
+
+  // Nacitanie vysledku
+  if (!traceTransfer("read output", buf_out.readAsync(0, out, sizeof(float) * out_w * out_h))) OCL_REPORT("Failed to read output");
+
+  return true;
+}
+
+
+/**
+ * Builds a Gaussian pyramid of n_levels levels below the input image.
+ * Every level is produced by the strided kernel with stride 2 and a 3x3 Gaussian mask
+ * directly into the interior of the zero-bordered buffer of the next level,
+ * so all levels are enqueued at once and the host waits only for the final readback.
+ * levels[k] holds level k + 1 with size ceil(w / 2^(k + 1)) x ceil(h / 2^(k + 1)).
+ */
+static bool corrOCLPyramid(const float *in, const int w, const int h, const int n_levels,
+                           std::vector<std::vector<float> > & levels, double & kernel_ms)
+{
+  std::cout << "*** corr_local_mem_strided pyramid (" << n_levels << " levels) ***" << std::endl;
+
+  const int stride = 2;
+  const float gauss[3 * 3] = {
+    1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,
+    2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,
+    1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f
+  };
+
+  trace::Span total("pyramid");
+  trace::Span stage("create context");
+
+  // Vytvorenie kontextu
+  QCLContext ctx;
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
+
+  // Vytvorenie fronty prikazov
+  QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
+  if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
+  ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
+
+  // Vypocet optimalnej local a global work_size
+  int warp_size = 32; //64;
+  int block_width  = warp_size;
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, 8);
+  int tile_width = warp_size;
+  int tile_height = block_height;
+
+  // rozmery urovni a ich bufferov (kazda uroven ma nulovy okraj sirky 1)
+  std::vector<int> lvl_w(n_levels + 1), lvl_h(n_levels + 1), buf_w(n_levels + 1), buf_h(n_levels + 1);
+  std::vector<int> grid_w(n_levels + 1), grid_h(n_levels + 1);
+
+  lvl_w[0] = w;
+  lvl_h[0] = h;
+
+  for (int k = 0; k <= n_levels; ++k)
+  {
+    int out_w, out_h;
+    stridedGeometry(lvl_w[k], lvl_h[k], stride, tile_width, tile_height,
+                    out_w, out_h, grid_w[k], grid_h[k], buf_w[k], buf_h[k]);
+    if (k < n_levels)
+    {
+      lvl_w[k + 1] = out_w;
+      lvl_h[k + 1] = out_h;
+    }
+
+    std::cerr << "level=" << k << ", w=" << lvl_w[k] << ", h=" << lvl_h[k]
+              << ", buf_w=" << buf_w[k] << ", buf_h=" << buf_h[k] << std::endl;
+  }
+
+  stage.next("allocate and write buffers");
+
+  // Alokacia pamate, buffery su vynulovane kvoli okraju
+  std::vector<float> zeros(static_cast<size_t>(buf_w[0]) * buf_h[0], 0.0f);
+  std::vector<QCLBuffer> bufs;
+
+  for (int k = 0; k <= n_levels; ++k)
+  {
+    bufs.push_back(ctx.createBufferCopy(zeros.data(), sizeof(float) * buf_w[k] * buf_h[k], QCLBuffer::ReadWrite));
+    if (bufs.back().isNull()) OCL_REPORT("Failed to create buffer of level " << k);
+  }
+
+  if (!traceTransfer("write input", bufs[0].writeRectAsync(QRect(0, 0, (w + 2) * sizeof(float), (h + 2)),
+                                                           in,
+                                                           buf_w[0] * sizeof(float),
+                                                           (w + 2) * sizeof(float))))
+  {
+    OCL_REPORT("Failed to write data input buffer");
+  }
+
+  QCLBuffer buf_mask = ctx.createBufferCopy(gauss, sizeof(float) * 3 * 3, QCLBuffer::ReadWrite);
+  if (buf_mask.isNull()) OCL_REPORT("Failed to create mask buffer");
+
+  stage.next("build program");
+
+  // Skompilovanie programu a vytvorenie kernelu
+  QString opts("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4 -DSTRIDE=%5");
+  QCLProgram program = ctx.buildProgramFromSourceFile(":/corr_local_mem_strided.cl",
+                                                      opts.arg(tile_width).arg(tile_height)
+                                                          .arg(block_width).arg(block_height)
+                                                          .arg(stride));
+  if (program.isNull()) OCL_REPORT("Failed to compile program");
+
+  QCLKernel kernel = program.createKernel("corr");
+  if (kernel.isNull()) OCL_REPORT("Failed to create kernel");
+
+  stage.next("run kernels");
+
+  // Spustenie vsetkych urovni naraz, poradie zabezpecuje in-order fronta
+  std::vector<QCLEvent> events;
+
+  for (int k = 0; k < n_levels; ++k)
+  {
+    kernel.setArg(0, bufs[k]);
+    kernel.setArg(1, buf_mask);
+    kernel.setArg(2, bufs[k + 1]);
+    kernel.setArg(3, buf_w[k]);
+    kernel.setArg(4, buf_w[k + 1]);
+    kernel.setArg(5, 1 + buf_w[k + 1]);     // vystup sa zapisuje dovnutra okraja dalsej urovne
+    kernel.setArg(6, lvl_w[k + 1]);
+    kernel.setArg(7, lvl_h[k + 1]);
+
+    kernel.setLocalWorkSize(block_width, block_height);
+    kernel.setGlobalWorkSize(grid_w[k] * block_width, grid_h[k] * block_height);
+
+    events.push_back(kernel.run());
+  }
+
+  stage.next("read output");
+
+  // Nacitanie vysledkov (prve citanie caka na dokoncenie vsetkych kernelov)
+  levels.resize(n_levels);
+  for (int k = 0; k < n_levels; ++k)
+  {
+    levels[k].resize(size_t(lvl_w[k + 1]) * lvl_h[k + 1]);
+
+    if (!traceTransfer("read output", bufs[k + 1].readRectAsync(QRect(sizeof(float), 1, lvl_w[k + 1] * sizeof(float), lvl_h[k + 1]),
+                                                                levels[k].data(),
+                                                                buf_w[k + 1] * sizeof(float),
+                                                                lvl_w[k + 1] * sizeof(float))))
+    {
+      OCL_REPORT("Failed to read level " << (k + 1));
+    }
+  }
+
+  kernel_ms = 0.0;
+  for (int k = 0; k < n_levels; ++k)
+  {
+    traceEvent("pyramid level", events[k]);
+    double ms = (events[k].finishTime() - events[k].runTime()) * 1e-6;
+    std::cout << "Execution time of level " << (k + 1) << " (" << lvl_w[k + 1] << "x" << lvl_h[k + 1] << "): " << ms << " ms" << std::endl;
+    kernel_ms += ms;
+  }
+
+  std::cout << "Execution time of all levels: " << kernel_ms << " ms" << std::endl;
+
+  return true;
+}
+
+
+static bool corrOCLFile(const image_io::InputImage & img, image_io::OutputImage & out_img, const float *mask, const char *program_name)
+{
+  std::cout << "*** " << program_name << " (file input) ***" << std::endl;
+
+  const int w = img.width();
+  const int h = img.height();
+  const bool convert = (img.type() != image_io::Float32) || img.isBigEndian();   // vstup sa konvertuje na zariadeni
+
+  // QRect udava sirku obdlznika v bajtoch ako int, prilis dlhe riadky by pretiekli
+  // (riadok vstupneho buffera ma najviac w + 2 + sirka tilu floatov)
+  const size_t max_row_bytes = std::max(img.rowBytes(), (size_t(w) + 2 + 32) * sizeof(float));
+  if (max_row_bytes > size_t(INT_MAX))
+  {
+    OCL_REPORT("Image rows are too long (" << max_row_bytes << " bytes, at most " << INT_MAX << " bytes are supported)");
+  }
+
+  trace::Span total(program_name);
+  trace::Span stage("create context");
+
+  // Vytvorenie kontextu
+  QCLContext ctx;
+  if (!ctx.create(OCL_DEVICE_TYPE)) OCL_REPORT("Failed to create OpenCL context");
+
+  // Vytvorenie fronty prikazov
+  QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
+  if (queue.isNull()) OCL_REPORT("Failed to enable profiling on command queue");
+  ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
+
+  // Vypocet optimalnej local a global work_size (rovnako ako v corrOCLLocalMem)
+  int warp_size = 32; //64;
+  int block_width  = warp_size;
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, warp_size);
+  while ((warp_size % block_height) != 0) --block_height;   // work-groupa nesmie byt vyssia ako tile
+  int tile_width = warp_size;
+  int tile_height = warp_size;
+  int grid_width  = (w + tile_width  - 1) / tile_width;
+
+  int in_w  = grid_width  * tile_width + 2;
+  int out_w = grid_width  * tile_width;
+
+  // Obrazok sa spracuva po pasoch riadkov s jednym riadkom halo nad a pod pasom.
+  // Vyska pasu je nasobok vysky tilu, ziadny buffer nesmie prekrocit CL_DEVICE_MAX_MEM_ALLOC_SIZE
+  // a indexy v kerneloch (int) nesmu pretiect.
+  const size_t max_alloc = size_t(ctx.defaultDevice().maximumAllocationSize());
+  const size_t buf_row_bytes = std::max(sizeof(float) * in_w, convert ? img.rowBytes() : size_t(0));
+  const size_t max_rows = std::min(max_alloc / buf_row_bytes, size_t(INT_MAX) / size_t(in_w));
+  if (max_rows < size_t(tile_height) + 2)
+  {
+    OCL_REPORT("Image rows are too long for the device (" << buf_row_bytes << " bytes per row, at most "
+               << max_alloc << " bytes per buffer)");
+  }
+
+  int band_height = int(std::min((max_rows - 2) / tile_height, (size_t(h) + tile_height - 1) / tile_height)) * tile_height;
+  int n_bands = (h - 1) / band_height + 1;
+  int grid_height = band_height / tile_height;   // pocet tilov na vysku v jednom pase
+
+  int in_h  = band_height + 2;
+  int out_h = band_height;
+
+  std::cerr << "grid_width=" << grid_width << ", grid_height=" << grid_height
+            << ", block_width=" << block_width << ", block_height=" << block_height
+            << ", tile_width=" << tile_width << ", tile_height=" << tile_height
+            << ", in_w=" << in_w << ", in_h=" << in_h
+            << ", out_w=" << out_w << ", out_h=" << out_h
+            << ", band_height=" << band_height << ", n_bands=" << n_bands
+            << ", pixel_bytes=" << image_io::bytesPerPixel(img.type())
+            << ", big_endian=" << img.isBigEndian()
+            << std::endl;
+
+  stage.next("allocate buffers");
+
+  QCLBuffer buf_in = ctx.createBufferDevice(sizeof(float) * in_w * in_h, QCLBuffer::ReadWrite);
+  if (buf_in.isNull()) OCL_REPORT("Failed to create input buffer");
+
+  QCLBuffer buf_mask = ctx.createBufferCopy(mask, sizeof(float) * 3 * 3, QCLBuffer::ReadWrite);
+  if (buf_mask.isNull()) OCL_REPORT("Failed to create mask buffer");
+
+  QCLBuffer buf_out = ctx.createBufferDevice(sizeof(float) * out_w * out_h, QCLBuffer::ReadWrite);
+  if (buf_out.isNull()) OCL_REPORT("Failed to create output buffer");
+
+  // surove data sa nahravaju do pomocneho buffera a na zariadeni sa skonvertuju na float
+  QCLBuffer buf_raw;
+  if (convert)
+  {
+    buf_raw = ctx.createBufferDevice(img.rowBytes() * in_h, QCLBuffer::ReadOnly);
+    if (buf_raw.isNull()) OCL_REPORT("Failed to create raw input buffer");
+  }
+
+  // nulovy lavy a pravy okraj (halo) sa pri nahravani pasov neprepisuje
+  std::vector<float> zeros(std::max(w + 2, in_h), 0.0f);
+  if ((!traceTransfer("write halo", buf_in.writeRectAsync(QRect(0,                       0, sizeof(float), in_h), zeros.data(), in_w * sizeof(float), sizeof(float)))) ||
+      (!traceTransfer("write halo", buf_in.writeRectAsync(QRect((w + 1) * sizeof(float), 0, sizeof(float), in_h), zeros.data(), in_w * sizeof(float), sizeof(float)))))
+  {
+    OCL_REPORT("Failed to clear halo of input buffer");
+  }
+
+  stage.next("build program");
+
+  // Skompilovanie programov a vytvorenie kernelov
+  QCLKernel conv_kernel;
+  if (convert)
+  {
+    static const char *pixel_types[] = { "uchar", "ushort", "float" };
+
+    QString conv_opts("-DPIXEL_T=%1 -DPIXEL_SIZE=%2 -DSWAP_BYTES=%3");
+    QCLProgram conv_program = ctx.buildProgramFromSourceFile(":/convert.cl",
+                                                             conv_opts.arg(pixel_types[img.type()])
+                                                                      .arg(image_io::bytesPerPixel(img.type()))
+                                                                      .arg(img.isBigEndian() ? 1 : 0));
+    if (conv_program.isNull()) OCL_REPORT("Failed to compile conversion program");
+
+    conv_kernel = conv_program.createKernel("convert");
+    if (conv_kernel.isNull()) OCL_REPORT("Failed to create conversion kernel");
+
+    conv_kernel.setArg(0, buf_raw);
+    conv_kernel.setArg(1, buf_in);
+    conv_kernel.setArg(2, w);
+    conv_kernel.setArg(3, in_w);
+    conv_kernel.setArg(4, w);
+    conv_kernel.setLocalWorkSize(16, 16);
+  }
+
+  QString opts("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4");
+  QCLProgram program = ctx.buildProgramFromSourceFile(QString(":/%1.cl").arg(program_name),
+                                                      opts.arg(tile_width).arg(tile_height)
+                                                          .arg(block_width).arg(block_height));
+  if (program.isNull()) OCL_REPORT("Failed to compile program");
+
+  QCLKernel kernel = program.createKernel("corr");
+  if (kernel.isNull()) OCL_REPORT("Failed to create kernel");
+
+  // Nastavenie parametrov kernelu
+  kernel.setArg(0, buf_in);
+  kernel.setArg(1, buf_mask);
+  kernel.setArg(2, buf_out);
+  kernel.setArg(3, in_w);
+  kernel.setArg(4, out_w);
+
+  // Nastavenie work size-ov
+  kernel.setLocalWorkSize(block_width, block_height);
+  kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
+
+  // Spracovanie pasov: nahranie priamo z namapovaneho suboru (bez medzikopie), kernel
+  // a zapis vysledku priamo do namapovaneho vystupneho suboru po pasoch riadkov.
+  // Citanie vysledku zo zariadenia a zapis stranok suboru na disk sa meraju zvlast.
+  typedef std::chrono::steady_clock Clock;
+  const int strip_height = 256;
+
+  double read_ms = 0.0, kernel_ms = 0.0, readback_ms = 0.0, write_ms = 0.0;
+
+  for (int j0 = 0; j0 < h; j0 += band_height)
+  {
+    int n = std::min(band_height, h - j0);   // pocet riadkov obrazku v pase
+
+    // riadky obrazku [r0, r1) vratane halo, riadok r patri do riadku r - j0 + 1 buffera
+    int r0 = (j0 > 0) ? (j0 - 1) : 0;
+    int r1 = (j0 + n < h) ? (j0 + n + 1) : h;
+
+    stage.next("upload input");
+
+    auto start = Clock::now();
+
+    // nulovy horny a dolny okraj obrazku
+    if ((j0 == 0) &&
+        (!traceTransfer("write halo", buf_in.writeRectAsync(QRect(0, 0, (w + 2) * sizeof(float), 1), zeros.data(), in_w * sizeof(float), (w + 2) * sizeof(float)))))
+    {
+      OCL_REPORT("Failed to clear halo of input buffer");
+    }
+
+    if ((j0 + n == h) &&
+        (!traceTransfer("write halo", buf_in.writeRectAsync(QRect(0, n + 1, (w + 2) * sizeof(float), 1), zeros.data(), in_w * sizeof(float), (w + 2) * sizeof(float)))))
+    {
+      OCL_REPORT("Failed to clear halo of input buffer");
+    }
+
+    for (int r = r0; r < r1; )
+    {
+      int rows = std::min(img.stripRows(r), r1 - r);
+
+      if (!convert)
+      {
+        // data su uz vo formate, ktory ocakava kernel
+        if (!traceTransfer("write input", buf_in.writeRectAsync(QRect(sizeof(float), r - j0 + 1, w * sizeof(float), rows),
+                                                                img.row(r),
+                                                                in_w * sizeof(float),
+                                                                img.rowBytes())))
+        {
+          OCL_REPORT("Failed to write data input buffer");
+        }
+      }
+      else
+      {
+        if (!traceTransfer("write raw input", buf_raw.writeRectAsync(QRect(0, r - j0 + 1, img.rowBytes(), rows),
+                                                                     img.row(r),
+                                                                     img.rowBytes(),
+                                                                     img.rowBytes())))
+        {
+          OCL_REPORT("Failed to write raw input buffer");
+        }
+      }
+
+      r += rows;
+    }
+
+    if (convert)
+    {
+      conv_kernel.setArg(5, r1 - r0);
+      conv_kernel.setArg(6, r0 - j0 + 1);
+      conv_kernel.setGlobalWorkSize((w + 15) / 16 * 16, (r1 - r0 + 15) / 16 * 16);
+
+      QCLEvent conv_ev(conv_kernel.run());
+      if (conv_ev.isNull()) OCL_REPORT("Failed to run conversion kernel");
+      conv_ev.waitForFinished();
+      if (conv_ev.isErrored()) OCL_REPORT("Conversion kernel failed");
+      traceEvent("convert", conv_ev);
+    }
+
+    read_ms += std::chrono::duration <double, std::milli>(Clock::now() - start).count();
+
+    stage.next("run kernel");
+
+    // Spustenie kernelu
+    QCLEvent ev(kernel.run());
+    if (ev.isNull()) OCL_REPORT("Failed to run kernel");
+    ev.waitForFinished();
+    if (ev.isErrored()) OCL_REPORT("Kernel failed");
+    traceEvent(program_name, ev);
+
+    kernel_ms += (ev.finishTime() - ev.runTime()) * 1e-6;
+
+    stage.next("read output");
+
+    // Nacitanie vysledku priamo do namapovaneho vystupneho suboru po pasoch riadkov
+    for (int j = 0; j < n; j += strip_height)
+    {
+      int m = std::min(strip_height, n - j);
+
+      start = Clock::now();
+
+      if (!traceTransfer("read output", buf_out.readRectAsync(QRect(0, j, w * sizeof(float), m),
+                                                              out_img.row(j0 + j),
+                                                              sizeof(float) * out_w,
+                                                              out_img.rowBytes())))
+      {
+        OCL_REPORT("Failed to read output");
+      }
+
+      auto end = Clock::now();
+      readback_ms += std::chrono::duration <double, std::milli>(end - start).count();
+
+      if (!out_img.flushRows(j0 + j, m)) return false;
+
+      write_ms += std::chrono::duration <double, std::milli>(Clock::now() - end).count();
+    }
+  }
+
+  stage.next("write output");
+
+  auto start = Clock::now();
+  if (!out_img.sync()) return false;
+  write_ms += std::chrono::duration <double, std::milli>(Clock::now() - start).count();
+
+  std::cout << "Input read time: " << read_ms << " ms, throughput: "
+            << ((img.rowBytes() * h) / (read_ms * 1e3)) << " MB/s" << std::endl;
+  std::cout << "Execution time of kernel: " << kernel_ms << " ms (" << n_bands << " bands of "
+            << band_height << " rows)" << std::endl;
+  std::cout << "Output readback time: " << readback_ms << " ms, throughput: "
+            << (out_img.fileSize() / (readback_ms * 1e3)) << " MB/s" << std::endl;
+  std::cout << "Output write time: " << write_ms << " ms, throughput: "
+            << (out_img.fileSize() / (write_ms * 1e3)) << " MB/s" << std::endl;
+
+  return true;
+}
+
+
+/**************************************** SPUSTANIE TESTOV ****************************************/
+
+//typedef bool (* TCorrFunc)(const float *in, const float *mask, float *out, const int w, const int h, bool use_v2);
+typedef bool (* TCorrFunc)(const float *in, const float *mask, float *out, const int w, const int h, const char *program_name, bool use_v2);
+
+// seed nahodnych vstupov (--seed), rovnaky seed da rovnake vstupy
+static uint64_t g_seed = input::DEFAULT_SEED;
+
+//static bool testFunc(TCorrFunc f, const float *ref, const float *in, const float *mask, float *out, const int w, const int h, bool use_v2)
+static bool testFunc(TCorrFunc f, const float *ref, const float *in, const float *mask, float *out, const int w, const int h, const char *program_name, bool use_v2)
+{
+  //if (!f(in, mask, out, w, h, use_v2)) return false;
+  if (!f(in, mask, out, w, h, program_name, use_v2)) return false;
+
+#ifdef DEBUG
+  std::cout << "C++:" << std::endl;    printArray2d(ref, w, h); std::cout << std::endl;
+  std::cout << "OpenCL:" << std::endl; printArray2d(out, w, h); std::cout << std::endl;
+#endif
+
+  std::cout << validate::compare(ref, out, w, h) << std::endl;
+
+  return true;
+}
+
+
+static bool runTestDebug(void)
+{
+  // Vygenerovanie testovacich dat
+  const int mask_w = 3;
+  const float mask[mask_w * mask_w] = {
+    1, 1, 1,
+    1, 1, 1,
+    1, 1, 1
+  };
+
+  int w = 40, h = 40;
+  //int w = 10, h = 10;
+  const float *in;
+  float *out_cpp, *out_ocl;
+
+  input::genSequential(in, out_cpp, out_ocl, w, h, mask_w / 2);
+  std::cout << "Input:" << std::endl;    printArray2d(in, w + 2, h + 2); std::cout << std::endl;
+  if (!corrReference(in, mask, out_cpp, w, h)) return false;
+  //if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, true)) return false;
+  //if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, w, h, false)) return false;
+  //if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_padding", true)) return false;
+  //if (!testFunc(corrOCLImage, out_cpp, in, mask, out_ocl, w, h, "corr_image", false)) return false;
+  if (!testFunc(corrOCLLocalMemInner, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_inner_tile", false)) return false;
+
+  delete [] in;
+  delete [] out_cpp;
+  delete [] out_ocl;
+
+  return true;
+}
+
+static bool runTest1(void)
+{
+  // Vygenerovanie testovacich dat
+  const int mask_w = 3;
+  const float mask[mask_w * mask_w] = {
+    1, 1, 1,
+    1, 1, 1,
+    1, 1, 1
+  };
+
+  int w = 10000, h = 10000;
+  const float *in;
+  float *out_cpp, *out_ocl;
+
+#ifdef DEBUG
+  input::genDebug(in, out_cpp, out_ocl, w, h);
+#else
+  input::genSequential(in, out_cpp, out_ocl, w, h, mask_w / 2);
+#endif
+
+  std::cout << "Test size: w=" << w << ", h=" << h << std::endl;
+
+  // vypocet referencnej implementacie
+  if (!corrReference(in, mask, out_cpp, w, h)) return false;
+
+  // OpenCL implementacia
+  if (!testFunc(corrOCLGlobalMem, out_cpp, in, mask, out_ocl, w, h, "corr_global_mem", false)) return false;
+  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem", false)) return false;
+  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem", true)) return false;
+  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_corners", false)) return false;
+  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_right_border", false)) return false;
+  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_right_border_2", false)) return false;
+  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_rows_joint", false)) return false;
+  //if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_float4", false)) return false;
+  if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_indexing", false)) return false;
+  if (!testFunc(corrOCLLocalMemShuffle, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_shuffle", false)) return false;
+  if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_padding", false)) return false;
+  if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_padding", true)) return false;
+  if (!testFunc(corrOCLImage, out_cpp, in, mask, out_ocl, w, h, "corr_image", false)) return false;
+  if (!testFunc(corrOCLImage, out_cpp, in, mask, out_ocl, w, h, "corr_image", true)) return false;
+  if (!testFunc(corrOCLLocalMemInner, out_cpp, in, mask, out_ocl, w, h, "corr_local_mem_inner_tile", false)) return false;
 
   delete [] in;
   delete [] out_cpp;
@@ -662,15 +1657,18 @@ static bool runTest2(void)
     const float *in;
     float *out_cpp, *out_ocl;
 
-    input::genRandom(in, out_cpp, out_ocl, tests_w[i], tests_h[i], mask_w / 2);
+    trace::Span stage("generate input");
+    input::genRandom(in, out_cpp, out_ocl, tests_w[i], tests_h[i], mask_w / 2, false, g_seed);
 
     std::cout << "==========================================================================" << std::endl;
-    std::cout << "Test size: w=" << tests_w[i] << ", h=" << tests_h[i] << std::endl;
+    std::cout << "Test size: w=" << tests_w[i] << ", h=" << tests_h[i] << ", seed=" << g_seed << std::endl;
 
     // vypocet referencnej implementacie
+    stage.next("reference");
     auto start = std::chrono::steady_clock::now();
     if (!corrReference(in, mask, out_cpp, tests_w[i], tests_h[i])) return false;
     auto end = std::chrono::steady_clock::now();
+    stage.end();
     std::cout << "Reference implementation total CPU time: " << std::chrono::duration <double, std::milli>(end - start).count() << " ms" << std::endl;
 
     // OpenCL implementacia
@@ -683,6 +1681,7 @@ static bool runTest2(void)
     if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, tests_w[i], tests_h[i], "corr_local_mem_rows_joint", false)) return false;
     //if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, tests_w[i], tests_h[i], "corr_local_mem_float4", false)) return false;
     if (!testFunc(corrOCLLocalMem, out_cpp, in, mask, out_ocl, tests_w[i], tests_h[i], "corr_local_mem_indexing", false)) return false;
+    if (!testFunc(corrOCLLocalMemShuffle, out_cpp, in, mask, out_ocl, tests_w[i], tests_h[i], "corr_local_mem_shuffle", false)) return false;
     if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, tests_w[i], tests_h[i], "corr_local_mem_padding", false)) return false;
     if (!testFunc(corrOCLLocalMemPadding, out_cpp, in, mask, out_ocl, tests_w[i], tests_h[i], "corr_local_mem_padding", true)) return false;
     if (!testFunc(corrOCLImage, out_cpp, in, mask, out_ocl, tests_w[i], tests_h[i], "corr_image", false)) return false;
@@ -697,10 +1696,223 @@ static bool runTest2(void)
   return true;
 }
 
+/**
+ * Compares the box filter engine with the generic local memory kernel
+ * for growing radius of a constant mask, to find the crossover point.
+ */
+static bool runTestBox(void)
+{
+  const int w = 4000, h = 4000;
+  const int n = 6;
+  const int radii[n] = { 1, 2, 3, 4, 8, 16 };
+
+  double generic_ms[n], box_ms[n], cpu_ms[n];
+
+  for (int r = 0; r < n; ++r)
+  {
+    const int radius = radii[r];
+    const int mask_w = 2 * radius + 1;
+    std::vector<float> mask(mask_w * mask_w, 1.0f / (mask_w * mask_w));
+
+    const float *in;
+    float *out_cpp, *out_ocl;
+
+    input::genRandom(in, out_cpp, out_ocl, w, h, radius, false, g_seed);
+
+    std::cout << "==========================================================================" << std::endl;
+    std::cout << "Test size: w=" << w << ", h=" << h << ", radius=" << radius << ", seed=" << g_seed << std::endl;
+
+    // referencia je priamy vypocet korelacie, nezavisly od beznych sum oboch box filtrov
+    box_filter::corrReferenceRadius(in, mask.data(), out_cpp, w, h, radius);
+
+    std::vector<float> out_box(size_t(w) * h);
+    auto start = std::chrono::steady_clock::now();
+    box_filter::corrBoxCPU(in, mask[0], out_box.data(), w, h, radius);
+    auto end = std::chrono::steady_clock::now();
+    cpu_ms[r] = std::chrono::duration <double, std::milli>(end - start).count();
+    std::cout << "Box filter total CPU time: " << cpu_ms[r] << " ms" << std::endl;
+    std::cout << validate::compare(out_cpp, out_box.data(), w, h) << std::endl;
+
+    if (!corrOCLLocalMemRadius(in, mask.data(), out_ocl, w, h, radius, generic_ms[r])) return false;
+    std::cout << validate::compare(out_cpp, out_ocl, w, h) << std::endl;
+
+    if (!corrOCLBox(in, mask.data(), out_ocl, w, h, radius, box_ms[r])) return false;
+    std::cout << validate::compare(out_cpp, out_ocl, w, h) << std::endl;
+
+    delete [] in;
+    delete [] out_cpp;
+    delete [] out_ocl;
+  }
+
+  std::cout << "==========================================================================" << std::endl;
+  std::cout << std::setw(8) << "radius" << std::setw(16) << "generic [ms]" << std::setw(16) << "box OCL [ms]" << std::setw(16) << "box CPU [ms]" << std::endl;
+  for (int r = 0; r < n; ++r)
+  {
+    std::cout << std::fixed << std::setprecision(3)
+              << std::setw(8) << radii[r] << std::setw(16) << generic_ms[r] << std::setw(16) << box_ms[r] << std::setw(16) << cpu_ms[r]
+              << std::endl;
+  }
+
+  return true;
+}
+
+
+/**
+ * Validates the strided kernel against the decimated reference
+ * and the pyramid builder against the same pyramid computed on the CPU.
+ */
+static bool runTestStrided(void)
+{
+  const int mask_w = 3;
+  const float mask[mask_w * mask_w] = {
+    1, 1, 1,
+    1, 1, 1,
+    1, 1, 1
+  };
+
+  const int w = 4000, h = 3000;
+  const float *in;
+  float *out_cpp, *out_ocl;
+
+  input::genRandom(in, out_cpp, out_ocl, w, h, mask_w / 2, false, g_seed);
+
+  std::cout << "==========================================================================" << std::endl;
+  std::cout << "Test size: w=" << w << ", h=" << h << ", seed=" << g_seed << std::endl;
+
+  const int strides[] = { 1, 2, 4 };
+  for (int stride : strides)
+  {
+    const int out_w = (w + stride - 1) / stride;
+    const int out_h = (h + stride - 1) / stride;
+    double kernel_ms;
+
+    if (!corrReferenceStrided(in, mask, out_cpp, w, h, stride)) return false;
+    if (!corrOCLLocalMemStrided(in, mask, out_ocl, w, h, stride, kernel_ms)) return false;
+    std::cout << validate::compare(out_cpp, out_ocl, out_w, out_h) << std::endl;
+  }
+
+  // Gaussovska pyramida
+  const int n_levels = 5;
+  const float gauss[3 * 3] = {
+    1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,
+    2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,
+    1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f
+  };
+
+  std::vector<std::vector<float> > levels;
+  double kernel_ms;
+  if (!corrOCLPyramid(in, w, h, n_levels, levels, kernel_ms)) return false;
+
+  // referencna pyramida, kazda uroven sa pred dalsim krokom obali nulovym okrajom
+  std::vector<float> padded(in, in + (w + 2) * (h + 2));
+  int lw = w, lh = h;
+
+  for (int k = 0; k < n_levels; ++k)
+  {
+    int nw = (lw + 1) / 2, nh = (lh + 1) / 2;
+    std::vector<float> ref(size_t(nw) * nh);
+    if (!corrReferenceStrided(padded.data(), gauss, ref.data(), lw, lh, 2)) return false;
+
+    std::cout << "Level " << (k + 1) << ": " << validate::compare(ref.data(), levels[k].data(), nw, nh) << std::endl;
+
+    padded.assign(size_t(nw + 2) * (nh + 2), 0.0f);
+    for (int j = 0; j < nh; ++j)
+    {
+      std::copy(ref.begin() + size_t(j) * nw, ref.begin() + size_t(j + 1) * nw, padded.begin() + size_t(j + 1) * (nw + 2) + 1);
+    }
+    lw = nw;
+    lh = nh;
+  }
+
+  delete [] in;
+  delete [] out_cpp;
+  delete [] out_ocl;
+
+  return true;
+}
+
+
+static bool runFile(int argc, char *argv[])
+{
+  if ((argc != 3) && (argc != 5) && (argc != 6))
+  {
+    std::cerr << "Usage: " << argv[0] << " <input.pgm|input.tif|input.raw> <output.raw> [raw_width raw_height [f32|u16|u8]]" << std::endl;
+    return false;
+  }
+
+  const int mask_w = 3;
+  const float mask[mask_w * mask_w] = {
+    1, 1, 1,
+    1, 1, 1,
+    1, 1, 1
+  };
+
+  int raw_w = (argc > 3) ? std::atoi(argv[3]) : 0;
+  int raw_h = (argc > 3) ? std::atoi(argv[4]) : 0;
+  image_io::PixelType raw_type = image_io::Float32;
+  if (argc > 5)
+  {
+    std::string t(argv[5]);
+    if (t == "u16") raw_type = image_io::UInt16;
+    else if (t == "u8") raw_type = image_io::UInt8;
+    else if (t != "f32") { std::cerr << "Unknown raw pixel type: " << t << std::endl; return false; }
+  }
+
+  image_io::InputImage img;
+  if (!img.open(argv[1], raw_w, raw_h, raw_type)) return false;
+
+  image_io::OutputImage out_img;
+  if (!out_img.create(argv[2], img.width(), img.height())) return false;
+
+  std::cout << "Test size: w=" << img.width() << ", h=" << img.height() << std::endl;
+
+  if (!corrOCLFile(img, out_img, mask, "corr_local_mem")) return false;
+
+  return out_img.close();
+}
+
 /**************************************** MAIN ****************************************/
 
-int main(void)
+int main(int argc, char *argv[])
 {
+  // zapnutie trasovania, napr. CORR_TRACE=trace.json (Chrome trace / Perfetto)
+  trace::init(std::getenv("CORR_TRACE"));
+
+  // seed nahodnych vstupov, napr. --seed 42 --box (musi byt prvy argument)
+  if ((argc >= 3) && (std::string(argv[1]) == "--seed"))
+  {
+    g_seed = std::strtoull(argv[2], nullptr, 0);
+    argv[2] = argv[0];
+    argv += 2;
+    argc -= 2;
+  }
+
+  // kontrola generatora nahodnych cisel voci znamym vystupom Philox4x32-10
+  if ((argc == 2) && (std::string(argv[1]) == "--selftest"))
+  {
+    bool ok = input::selfTest();
+    std::cout << "Philox4x32-10 known-answer test " << (ok ? "passed" : "failed") << std::endl;
+    return ok ? 0 : 1;
+  }
+
+  // porovnanie box filtra so vseobecnym kernelom
+  if ((argc == 2) && (std::string(argv[1]) == "--box")) return runTestBox() ? 0 : 1;
+
+  // decimovana korelacia a pyramida
+  if ((argc == 2) && (std::string(argv[1]) == "--strided")) return runTestStrided() ? 0 : 1;
+
+  // server pre lokalnych klientov, napr. --server /tmp/corr_server.sock 16
+  if ((argc >= 2) && (argc <= 4) && (std::string(argv[1]) == "--server"))
+  {
+    server::Options opts;
+    if (argc > 2) opts.socket_path = argv[2];
+    if (argc > 3) opts.max_batch = std::max(1, std::atoi(argv[3]));
+    return server::run(opts) ? 0 : 1;
+  }
+
+  // spracovanie obrazku zo suboru
+  if (argc > 1) return runFile(argc, argv) ? 0 : 1;
+
   //if (!runTest1()) return 1;
   if (!runTest2()) return 1;
   //if (!runTestDebug()) return 1;
@@ -0,0 +1,56 @@
+#ifndef OCL_COMMON_H
+#define OCL_COMMON_H
+
+#include "trace.h"
+
+#include <QtOpenCL/qclcontext.h>
+
+/**
+ * Settings and tracing helpers shared by all code that owns an OpenCL context
+ * (the launchers in main.cpp and the correlation server).
+ */
+
+// typ zariadenia, na ktorom sa spustaju kernely (napr. QCLDevice::CPU pre pocl)
+#ifndef OCL_DEVICE_TYPE
+#define OCL_DEVICE_TYPE QCLDevice::GPU
+#endif
+
+
+/** Zaznamena casy z profilovania OpenCL prikazu */
+inline void traceEvent(const char *name, const QCLEvent & ev)
+{
+  if (!trace::enabled()) return;
+  trace::deviceSpan(name, ev.queueTime(), ev.submitTime(), ev.runTime(), ev.finishTime());
+}
+
+
+/**
+ * Pocka na dokoncenie prenosu a zaznamena ho ako OpenCL prikaz,
+ * vrati false ak sa ho nepodarilo zaradit alebo skoncil chybou
+ */
+inline bool traceTransfer(const char *name, QCLEvent ev)
+{
+  if (ev.isNull()) return false;
+  ev.waitForFinished();
+  if (ev.isErrored()) return false;
+  traceEvent(name, ev);
+  return true;
+}
+
+
+/** Zosynchronizuje hodiny zariadenia s hodinami hosta pomocou markeru v prazdnej fronte */
+inline void traceCalibrate(QCLContext & ctx)
+{
+  if (!trace::enabled()) return;
+
+  // marker v prazdnej fronte skonci niekde medzi zaradenim a navratom z cakania,
+  // stred intervalu nezapocita do posunu hodin cas prebudenia hosta
+  uint64_t before_ns = trace::now();
+  QCLEvent ev(ctx.marker());
+  ev.waitForFinished();
+  uint64_t after_ns = trace::now();
+
+  if (ev.finishTime() != 0) trace::setDeviceClock(ev.finishTime(), before_ns + (after_ns - before_ns) / 2);
+}
+
+#endif // OCL_COMMON_H
@@ -0,0 +1,33 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+/**
+ * Runs f(t, begin, end) on n_threads threads, thread t gets the contiguous part [begin, end) of [0, n).
+ * If n_threads is 0, all hardware threads are used. Returns the number of started threads.
+ */
+template <typename F>
+int parallelFor(int n, int n_threads, F f)
+{
+  if (n_threads <= 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+  n_threads = std::max(1, std::min(n_threads, n));
+
+  std::vector<std::thread> threads;
+  int chunk = (n + n_threads - 1) / n_threads;
+
+  for (int t = 0; t < n_threads; ++t)
+  {
+    int begin = t * chunk;
+    int end = std::min(n, begin + chunk);
+    if (begin < end) threads.emplace_back(f, t, begin, end);
+  }
+
+  for (std::thread & t : threads) t.join();
+
+  return n_threads;
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,734 @@
+#include "server.h"
+#include "ocl_common.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+
+#define SRV_REPORT(msg) \
+  do { \
+    std::cerr << msg << std::endl; \
+    return false; \
+  } while (0)
+
+
+
+namespace {
+
+// varianty s rovnakym rozhranim a rozdelenim na tily ako corr_local_mem (vid corrOCLLocalMem)
+const char *variants[] = {
+  "corr_local_mem",
+  "corr_local_mem_corners",
+  "corr_local_mem_right_border",
+  "corr_local_mem_right_border_2",
+  "corr_local_mem_rows_joint",
+  "corr_local_mem_indexing"
+};
+
+const int MAX_FRAME_SIZE = 16384;
+const size_t MAX_MAPPED_FRAMES = 64;
+const size_t MAX_RECV_FDS = 16;             // deskriptory prijate jednym recvmsg
+const size_t MAX_PENDING_REPLIES = 1024;    // klient, ktory necita odpovede, sa odpoji
+
+std::atomic<bool> g_stop(false);
+
+void onSignal(int)
+{
+  g_stop = true;
+}
+
+
+/**
+ * Client connection with a non-blocking socket, the socket is closed when the last job of the client is done.
+ * Replies are appended to out by the GPU thread and sent by whichever thread finds the socket writable,
+ * so a client that stops reading never blocks the batch loop.
+ */
+struct Connection
+{
+  explicit Connection(int fd) : fd(fd) { }
+  ~Connection(void)
+  {
+    for (int frame_fd : frame_fds) ::close(frame_fd);
+    ::close(fd);
+  }
+
+  int fd;
+  std::string in;                 // prijate, nespracovane bajty (iba IO vlakno)
+  std::deque<int> frame_fds;      // prijate deskriptory framov, jeden ku kazdej poziadavke (iba IO vlakno)
+  std::map<std::pair<dev_t, ino_t>, std::shared_ptr<ipc::Frame> > frames;   // namapovane framy podla objektu (iba IO vlakno)
+
+  std::mutex mutex;     // chrani out a closed
+  std::string out;      // odpovede cakajuce na odoslanie
+  bool closed = false;
+};
+
+
+struct Job
+{
+  std::shared_ptr<Connection> conn;
+  std::shared_ptr<ipc::Frame> frame;    // nullptr, ak sa frame nepodarilo namapovat
+  ipc::Request req;
+  uint64_t enqueued;
+};
+
+
+/** Queue of jobs shared by all clients */
+class JobQueue
+{
+  public:
+    void push(Job && job)
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+      }
+      m_cond.notify_one();
+    }
+
+    /**
+     * Waits for a job, then gives other clients batch_wait_us to add theirs
+     * and takes up to max_batch jobs. depth is the number of waiting jobs before the batch was taken.
+     * Returns false when no job arrived before the timeout.
+     */
+    bool popBatch(std::vector<Job> & batch, int max_batch, int batch_wait_us, size_t & depth)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      if (!m_cond.wait_for(lock, std::chrono::milliseconds(100), [this] { return !m_jobs.empty(); })) return false;
+
+      if ((int(m_jobs.size()) < max_batch) && (batch_wait_us > 0))
+      {
+        m_cond.wait_for(lock, std::chrono::microseconds(batch_wait_us),
+                        [this, max_batch] { return int(m_jobs.size()) >= max_batch; });
+      }
+
+      depth = m_jobs.size();
+
+      batch.clear();
+      while ((!m_jobs.empty()) && (int(batch.size()) < max_batch))
+      {
+        batch.push_back(std::move(m_jobs.front()));
+        m_jobs.pop_front();
+      }
+
+      return true;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Job> m_jobs;
+};
+
+
+/** Latencies and batch sizes since the last report and since the start */
+class Stats
+{
+  public:
+    void record(uint64_t queue_ns, uint64_t total_ns)
+    {
+      m_total.push_back(total_ns);
+      m_queue_sum += queue_ns;
+      ++m_jobs_all;
+    }
+
+    void batch(size_t size, size_t depth)
+    {
+      ++m_batches;
+      m_batch_jobs += size;
+      m_max_depth = std::max(m_max_depth, depth);
+    }
+
+    /** Prints the interval statistics and starts a new interval */
+    void report(double interval_s)
+    {
+      if (m_total.empty()) return;
+
+      std::sort(m_total.begin(), m_total.end());
+
+      std::cout << std::fixed << std::setprecision(3)
+                << "jobs=" << m_total.size()
+                << " (" << (m_total.size() / interval_s) << "/s, " << m_jobs_all << " total)"
+                << ", batch=" << (double(m_batch_jobs) / m_batches)
+                << ", max_depth=" << m_max_depth
+                << ", queue=" << (m_queue_sum * 1e-6 / m_total.size()) << " ms"
+                << ", latency p50=" << (percentile(0.50) * 1e-6)
+                << " p99=" << (percentile(0.99) * 1e-6)
+                << " max=" << (m_total.back() * 1e-6) << " ms"
+                << std::endl;
+      std::cout.unsetf(std::ios_base::floatfield);
+
+      m_total.clear();
+      m_queue_sum = 0;
+      m_batches = 0;
+      m_batch_jobs = 0;
+      m_max_depth = 0;
+    }
+
+  private:
+    uint64_t percentile(double p) const
+    {
+      return m_total[std::min(m_total.size() - 1, size_t(p * m_total.size()))];
+    }
+
+  private:
+    std::vector<uint64_t> m_total;
+    uint64_t m_queue_sum = 0;
+    uint64_t m_jobs_all = 0;
+    size_t m_batches = 0;
+    size_t m_batch_jobs = 0;
+    size_t m_max_depth = 0;
+};
+
+
+/** Device buffers of one job of a batch, reused while the frame fits into them */
+struct Slot
+{
+  QCLBuffer in;
+  QCLBuffer out;
+  QCLBuffer mask;
+  size_t in_bytes = 0;
+  size_t out_bytes = 0;
+};
+
+
+/** Creates the listening socket, an old socket file left by a killed server is removed */
+int listenSocket(const char *path)
+{
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (std::strlen(path) >= sizeof(addr.sun_path))
+  {
+    std::cerr << "Socket path too long: " << path << std::endl;
+    return -1;
+  }
+  std::strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+    return -1;
+  }
+
+  unlink(path);
+
+  // socket je dostupny iba vlastnikovi servera, prava sa nastavia este pred listen(),
+  // takze sa nikto nepripoji, kym ich urcuje umask
+  if ((bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) || (chmod(path, 0600) != 0) ||
+      (listen(fd, 64) != 0))
+  {
+    std::cerr << "Failed to listen on " << path << ": " << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+
+/** Maps the frame of a received request (takes ownership of frame_fd) and queues the job */
+bool handleRequest(const std::shared_ptr<Connection> & conn, const ipc::Request & req, int frame_fd, JobQueue & queue)
+{
+  Job job;
+  job.req = req;
+  if (job.req.magic != ipc::MAGIC)
+  {
+    ::close(frame_fd);
+    SRV_REPORT("Invalid request, closing connection");
+  }
+
+  job.req.program[ipc::MAX_NAME - 1] = '\0';
+  job.conn = conn;
+  job.enqueued = trace::now();
+
+  const int w = job.req.w;
+  const int h = job.req.h;
+
+  // klient zvycajne posiela stale tie iste framy, preto sa mapovanie drzi az do odpojenia;
+  // kym je objekt namapovany, jeho inode nemoze dostat iny objekt
+  struct stat st;
+  if ((w <= 0) || (h <= 0) || (w > MAX_FRAME_SIZE) || (h > MAX_FRAME_SIZE) || (fstat(frame_fd, &st) != 0))
+  {
+    ::close(frame_fd);
+  }
+  else
+  {
+    const std::pair<dev_t, ino_t> key(st.st_dev, st.st_ino);
+    auto it = conn->frames.find(key);
+    if ((it != conn->frames.end()) && (it->second->width() == w) && (it->second->height() == h))
+    {
+      ::close(frame_fd);
+      job.frame = it->second;
+    }
+    else
+    {
+      if (conn->frames.size() >= MAX_MAPPED_FRAMES) conn->frames.clear();
+
+      std::shared_ptr<ipc::Frame> frame = std::make_shared<ipc::Frame>();
+      if (frame->open(frame_fd, w, h))
+      {
+        conn->frames[key] = frame;
+        job.frame = frame;
+      }
+    }
+  }
+
+  // aj chybna uloha ide do fronty, aby odpovede prisli v poradi poziadaviek
+  queue.push(std::move(job));
+
+  return true;
+}
+
+
+/** Reads everything the client has sent so far and queues its complete requests, false when the client is gone */
+bool readRequests(const std::shared_ptr<Connection> & conn, JobQueue & queue)
+{
+  char buf[4096];
+  union { char buf[CMSG_SPACE(sizeof(int) * MAX_RECV_FDS)]; cmsghdr align; } ctrl;
+  bool open = true;
+
+  while (true)
+  {
+    iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = sizeof(buf);
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    ssize_t n = recvmsg(conn->fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (n > 0)
+    {
+      // deskriptory framov prichadzaju v poradi poziadaviek, ku ktorym patria
+      for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+      {
+        if ((cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_RIGHTS)) continue;
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t k = 0; k < count; ++k)
+        {
+          int frame_fd;
+          std::memcpy(&frame_fd, CMSG_DATA(cmsg) + k * sizeof(int), sizeof(int));
+          conn->frame_fds.push_back(frame_fd);
+        }
+      }
+      // stratene deskriptory by uz nebolo mozne priradit k poziadavkam
+      if (msg.msg_flags & MSG_CTRUNC) SRV_REPORT("Too many descriptors in one message, closing connection");
+
+      conn->in.append(buf, size_t(n));
+      continue;
+    }
+    if ((n < 0) && (errno == EINTR)) continue;
+    if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) break;
+    open = false;   // koniec spojenia alebo chyba
+    break;
+  }
+
+  // poziadavka moze prist po castiach, spracuju sa iba cele
+  size_t pos = 0;
+  while (conn->in.size() - pos >= sizeof(ipc::Request))
+  {
+    if (conn->frame_fds.empty()) SRV_REPORT("Request without a frame descriptor, closing connection");
+
+    ipc::Request req;
+    std::memcpy(&req, conn->in.data() + pos, sizeof(req));
+    pos += sizeof(req);
+    int frame_fd = conn->frame_fds.front();
+    conn->frame_fds.pop_front();
+    if (!handleRequest(conn, req, frame_fd, queue)) return false;
+  }
+  conn->in.erase(0, pos);
+
+  return open;
+}
+
+
+/** Sends as much of the pending replies as the socket takes without blocking, conn.mutex has to be locked */
+bool sendPending(Connection & conn)
+{
+  while (!conn.out.empty())
+  {
+    ssize_t n = send(conn.fd, conn.out.data(), conn.out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n > 0) { conn.out.erase(0, size_t(n)); continue; }
+    if ((n < 0) && (errno == EINTR)) continue;
+    return (n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+  }
+
+  return true;
+}
+
+
+/** Marks the connection as closed, its pending replies are dropped, conn.mutex has to be locked */
+void closeLocked(Connection & conn)
+{
+  conn.closed = true;
+  conn.out.clear();
+  shutdown(conn.fd, SHUT_RDWR);
+}
+
+
+/**
+ * Queues a reply and tries to send it right away.
+ * Returns true if part of it is still pending, so the IO thread has to wait for POLLOUT.
+ * A client with too many unread replies is disconnected.
+ */
+bool queueReply(Connection & conn, const ipc::Reply & reply)
+{
+  std::lock_guard<std::mutex> lock(conn.mutex);
+  if (conn.closed) return false;
+
+  if (conn.out.size() >= MAX_PENDING_REPLIES * sizeof(reply))
+  {
+    std::cerr << "Client does not read its replies, closing connection" << std::endl;
+    closeLocked(conn);
+    return false;
+  }
+
+  conn.out.append(reinterpret_cast<const char *>(&reply), sizeof(reply));
+  if (!sendPending(conn))
+  {
+    closeLocked(conn);
+    return false;
+  }
+
+  return !conn.out.empty();
+}
+
+
+/**
+ * Accepts clients, reads their requests and sends the replies the GPU thread could not send
+ * without blocking, until the server is stopped. wake_fd becomes readable when new replies are pending.
+ */
+void ioLoop(int listen_fd, int wake_fd, JobQueue & queue)
+{
+  std::vector<pollfd> fds;
+  std::vector<std::shared_ptr<Connection> > conns;   // conns[i] patri k fds[i + 2]
+
+  while (!g_stop)
+  {
+    fds.clear();
+    fds.push_back(pollfd { listen_fd, POLLIN, 0 });
+    fds.push_back(pollfd { wake_fd, POLLIN, 0 });
+    for (const std::shared_ptr<Connection> & conn : conns)
+    {
+      std::lock_guard<std::mutex> lock(conn->mutex);
+      fds.push_back(pollfd { conn->fd, short(conn->out.empty() ? POLLIN : (POLLIN | POLLOUT)), 0 });
+    }
+
+    int n = poll(fds.data(), fds.size(), 100);
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+      g_stop = true;
+      break;
+    }
+    if (n == 0) continue;
+
+    if (fds[1].revents & POLLIN)
+    {
+      char buf[256];
+      while (read(wake_fd, buf, sizeof(buf)) > 0) { }
+    }
+
+    for (size_t i = conns.size(); i-- > 0; )
+    {
+      short revents = fds[i + 2].revents;
+      if (revents == 0) continue;
+
+      Connection & conn = *conns[i];
+      bool ok = true;
+
+      if (revents & POLLOUT)
+      {
+        std::lock_guard<std::mutex> lock(conn.mutex);
+        ok = sendPending(conn);
+      }
+
+      if (ok && (revents & (POLLIN | POLLHUP | POLLERR))) ok = readRequests(conns[i], queue);
+
+      if (!ok)
+      {
+        // klient sa odpojil, socket sa zatvori az po dokonceni jeho uloh
+        {
+          std::lock_guard<std::mutex> lock(conn.mutex);
+          closeLocked(conn);
+        }
+        conns.erase(conns.begin() + i);
+      }
+    }
+
+    if (fds[0].revents & POLLIN)
+    {
+      int fd = accept(listen_fd, nullptr, nullptr);
+      if (fd >= 0)
+      {
+        // prava socketu nestacia, ak ho niekto premiestnil alebo zmenil, preto sa overi aj klient
+        ucred cred;
+        socklen_t len = sizeof(cred);
+        if ((getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) || (cred.uid != geteuid()))
+        {
+          std::cerr << "Rejected client of another user" << std::endl;
+          ::close(fd);
+        }
+        else
+        {
+          fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+          conns.push_back(std::make_shared<Connection>(fd));
+        }
+      }
+    }
+  }
+}
+
+} // End of anonymous namespace
+
+
+
+namespace server {
+
+bool run(const Options & opts)
+{
+  // Vytvorenie kontextu
+  QCLContext ctx;
+  if (!ctx.create(OCL_DEVICE_TYPE)) SRV_REPORT("Failed to create OpenCL context");
+
+  // Vytvorenie fronty prikazov
+  QCLCommandQueue queue(ctx.createCommandQueue(CL_QUEUE_PROFILING_ENABLE));
+  if (queue.isNull()) SRV_REPORT("Failed to enable profiling on command queue");
+  ctx.setCommandQueue(queue);
+  traceCalibrate(ctx);
+
+  // rovnake rozdelenie na tily ako v corrOCLLocalMem
+  int warp_size = 32; //64;
+  int block_width  = warp_size;
+  int tile_width = warp_size;
+  int tile_height = warp_size;
+  int block_height = std::min(ctx.defaultDevice().maximumWorkItemsPerGroup() / warp_size, tile_height);   // pocl hlasi az 4096 work-itemov
+  while ((tile_height % block_height) != 0) --block_height;   // kernely spracuvaju tile po WG_H riadkoch
+
+  // Skompilovanie vsetkych variant raz pri starte servera
+  std::map<std::string, QCLKernel> kernels;
+  QString build_opts = QString("-DTILE_W=%1 -DTILE_H=%2 -DWG_W=%3 -DWG_H=%4")
+                           .arg(tile_width).arg(tile_height).arg(block_width).arg(block_height);
+
+  for (const char *name : variants)
+  {
+    QCLProgram program = ctx.buildProgramFromSourceFile(QString(":/%1.cl").arg(name), build_opts);
+    if (program.isNull())
+    {
+      std::cerr << "Failed to compile " << name << ", variant disabled" << std::endl;
+      continue;
+    }
+
+    QCLKernel kernel = program.createKernel("corr");
+    if (kernel.isNull())
+    {
+      std::cerr << "Failed to create kernel of " << name << ", variant disabled" << std::endl;
+      continue;
+    }
+
+    kernel.setLocalWorkSize(block_width, block_height);
+    kernels[name] = kernel;
+  }
+
+  if (kernels.empty()) SRV_REPORT("No kernel variant could be compiled for this device");
+
+  int listen_fd = listenSocket(opts.socket_path);
+  if (listen_fd < 0) return false;
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  std::cout << "Serving " << kernels.size() << " variants on " << opts.socket_path
+            << " (max_batch=" << opts.max_batch << ", batch_wait=" << opts.batch_wait_us << " us)" << std::endl;
+
+  // GPU vlakno cez tuto rurku zobudi IO vlakno, ked ostanu neodoslane odpovede
+  int wake[2];
+  if (pipe(wake) != 0)
+  {
+    ::close(listen_fd);
+    SRV_REPORT("Failed to create pipe: " << std::strerror(errno));
+  }
+  fcntl(wake[0], F_SETFL, fcntl(wake[0], F_GETFL) | O_NONBLOCK);
+  fcntl(wake[1], F_SETFL, fcntl(wake[1], F_GETFL) | O_NONBLOCK);
+
+  JobQueue jobs;
+  std::thread io(ioLoop, listen_fd, wake[0], std::ref(jobs));
+  trace::setThreadName("server batches");
+
+  std::vector<Slot> slots(opts.max_batch);
+  std::vector<Job> batch;
+  std::vector<QCLEvent> write_evs(opts.max_batch);
+  std::vector<QCLEvent> kernel_evs(opts.max_batch);
+  std::vector<QCLEvent> read_evs(opts.max_batch);
+  std::vector<int> status(opts.max_batch);
+  Stats stats;
+  uint64_t last_report = trace::now();
+
+  while (!g_stop)
+  {
+    size_t depth = 0;
+    bool have_batch = jobs.popBatch(batch, opts.max_batch, opts.batch_wait_us, depth);
+
+    uint64_t taken = trace::now();
+    if (taken - last_report >= uint64_t(opts.report_s) * 1000000000ull)
+    {
+      stats.report((taken - last_report) * 1e-9);
+      last_report = taken;
+    }
+
+    if (!have_batch) continue;
+
+    trace::Span span("batch");
+    stats.batch(batch.size(), depth);
+
+    // Zaradenie vsetkych uloh davky do fronty bez cakania (fronta je in-order)
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      const ipc::Request & req = batch[i].req;
+      Slot & slot = slots[i];
+
+      status[i] = ipc::Ok;
+
+      if (batch[i].frame == nullptr) { status[i] = ipc::ErrFrame; continue; }
+
+      auto it = kernels.find(req.program);
+      if (it == kernels.end()) { status[i] = ipc::ErrProgram; continue; }
+      QCLKernel & kernel = it->second;
+
+      const int w = req.w;
+      const int h = req.h;
+      int grid_width  = (w + tile_width  - 1) / tile_width;
+      int grid_height = (h + tile_height - 1) / tile_height;
+      int in_w  = grid_width  * tile_width + 2;
+      int in_h  = grid_height * tile_height + 2;
+      int out_w = grid_width  * tile_width;
+      int out_h = grid_height * tile_height;
+
+      // buffery sa prealokuju iba ked frame nevojde do existujucich
+      size_t in_bytes = sizeof(float) * in_w * in_h;
+      size_t out_bytes = sizeof(float) * out_w * out_h;
+      if (slot.in_bytes < in_bytes)
+      {
+        slot.in = ctx.createBufferDevice(in_bytes, QCLBuffer::ReadOnly);
+        slot.in_bytes = slot.in.isNull() ? 0 : in_bytes;
+      }
+      if (slot.out_bytes < out_bytes)
+      {
+        slot.out = ctx.createBufferDevice(out_bytes, QCLBuffer::WriteOnly);
+        slot.out_bytes = slot.out.isNull() ? 0 : out_bytes;
+      }
+      if (slot.mask.isNull()) slot.mask = ctx.createBufferDevice(sizeof(req.mask), QCLBuffer::ReadOnly);
+      if ((slot.in_bytes == 0) || (slot.out_bytes == 0) || slot.mask.isNull()) { status[i] = ipc::ErrDevice; continue; }
+
+      // vstup ide priamo zo zdielanej pamate klienta, bez medzikopie
+      write_evs[i] = slot.in.writeRectAsync(QRect(0, 0, (w + 2) * sizeof(float), h + 2),
+                                            batch[i].frame->in(),
+                                            in_w * sizeof(float),
+                                            (w + 2) * sizeof(float));
+      if (write_evs[i].isNull()) { status[i] = ipc::ErrDevice; continue; }
+
+      // pri chybe sa caka na posledny zaradeny prikaz (fronta je in-order), aby nic necitalo frame po odpovedi
+      QCLEvent mask_ev = slot.mask.writeAsync(0, req.mask, sizeof(req.mask));
+      if (mask_ev.isNull()) { write_evs[i].waitForFinished(); status[i] = ipc::ErrDevice; continue; }
+
+      kernel.setArg(0, slot.in);
+      kernel.setArg(1, slot.mask);
+      kernel.setArg(2, slot.out);
+      kernel.setArg(3, in_w);
+      kernel.setArg(4, out_w);
+      kernel.setGlobalWorkSize(grid_width * block_width, grid_height * block_height);
+      kernel_evs[i] = kernel.run();
+      if (kernel_evs[i].isNull()) { mask_ev.waitForFinished(); status[i] = ipc::ErrDevice; continue; }
+
+      read_evs[i] = slot.out.readRectAsync(QRect(0, 0, w * sizeof(float), h),
+                                           batch[i].frame->out(),
+                                           out_w * sizeof(float),
+                                           w * sizeof(float));
+      if (read_evs[i].isNull()) { kernel_evs[i].waitForFinished(); status[i] = ipc::ErrDevice; continue; }
+    }
+
+    // Odpovede v poradi davky, kazda hned po precitani vystupu danej ulohy
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      Job & job = batch[i];
+
+      ipc::Reply reply;
+      std::memset(&reply, 0, sizeof(reply));
+      reply.job_id = job.req.job_id;
+      reply.batch_size = uint32_t(batch.size());
+      reply.queue_depth = uint32_t(depth);
+
+      if (status[i] == ipc::Ok)
+      {
+        read_evs[i].waitForFinished();
+        if (write_evs[i].isErrored() || kernel_evs[i].isErrored() || read_evs[i].isErrored())
+        {
+          status[i] = ipc::ErrDevice;
+        }
+        else
+        {
+          reply.kernel_ns = kernel_evs[i].finishTime() - kernel_evs[i].runTime();
+          traceEvent("write input", write_evs[i]);
+          traceEvent(job.req.program, kernel_evs[i]);
+          traceEvent("read output", read_evs[i]);
+        }
+      }
+      reply.status = status[i];
+
+      uint64_t done = trace::now();
+      reply.queue_ns = taken - job.enqueued;
+      reply.run_ns = done - taken;
+      stats.record(reply.queue_ns, done - job.enqueued);
+
+      // odpoved sa neodosiela blokujuco, zvysok odosle IO vlakno (odpojeny klient sa ignoruje)
+      if (queueReply(*job.conn, reply))
+      {
+        // plna rurka (EAGAIN) znamena, ze IO vlakno uz ma co zobudit
+        char c = 0;
+        ssize_t n = write(wake[1], &c, 1);
+        (void) n;
+      }
+    }
+
+    batch.clear();
+  }
+
+  io.join();
+  ::close(listen_fd);
+  ::close(wake[0]);
+  ::close(wake[1]);
+  unlink(opts.socket_path);
+
+  stats.report((trace::now() - last_report) * 1e-9);
+  std::cout << "Server stopped" << std::endl;
+
+  return true;
+}
+
+} // End of server namespace
@@ -0,0 +1,30 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "ipc.h"
+
+/**
+ * Local correlation server.
+ * One process owns the OpenCL context and the compiled kernel variants,
+ * clients connect over a Unix domain socket (see ipc.h) instead of creating
+ * their own contexts. Jobs of all clients go into one queue, the pending jobs
+ * are taken as a batch and their uploads, kernels and readbacks are enqueued
+ * back to back, so the device does not idle between jobs of different clients.
+ * Queue depth, batch size and latency percentiles are printed periodically.
+ */
+namespace server {
+
+struct Options
+{
+  const char *socket_path = ipc::DEFAULT_SOCKET;
+  int max_batch = 16;           // najviac uloh v jednej davke
+  int batch_wait_us = 200;      // ako dlho sa po prichode prvej ulohy caka na dalsie
+  int report_s = 5;             // interval vypisu statistik
+};
+
+/** Serves clients until SIGINT or SIGTERM, returns false if the server could not start */
+bool run(const Options & opts);
+
+} // End of server namespace
+
+#endif // SERVER_H
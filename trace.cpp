@@ -0,0 +1,218 @@
+#include "trace.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+
+
+
+namespace {
+
+// druhy udalosti: host spany maju vlastne vlakno v Chrome trace pre kazde vlakno programu,
+// vykonanie na zariadeni (in-order fronta) jedno spolocne vlakno a cakanie vo fronte
+// su asynchronne udalosti s vlastnym id, pretoze cakajuce prikazy sa prekryvaju
+enum Kind { KindHost, KindQueued, KindDevice };
+
+const int TID_DEVICE = 1;
+const int TID_FIRST_HOST = 2;
+
+struct Event
+{
+  std::string name;
+  Kind kind;
+  int tid;          // vlakno hosta pre KindHost
+  uint64_t id;      // id prikazu pre KindQueued
+  uint64_t begin;   // ns, host clock
+  uint64_t end;
+  uint64_t queued;  // povodne OpenCL casy (device clock), 0 pre host udalosti
+  uint64_t submit;
+  uint64_t start;
+  uint64_t finish;
+};
+
+std::string g_path;
+std::mutex g_mutex;
+std::vector<Event> g_events;
+std::map<int, std::string> g_thread_names;
+int g_next_tid = TID_FIRST_HOST;
+uint64_t g_next_id = 1;
+uint64_t g_origin = 0;
+int64_t g_device_offset = 0;
+
+thread_local int t_tid = 0;
+
+
+/** Chrome trace tid of the calling thread, g_mutex has to be locked */
+int threadTid(void)
+{
+  if (t_tid == 0)
+  {
+    t_tid = g_next_tid++;
+    if (g_thread_names.find(t_tid) == g_thread_names.end())
+    {
+      g_thread_names[t_tid] = (t_tid == TID_FIRST_HOST) ? std::string("host") : "host " + std::to_string(t_tid - TID_FIRST_HOST);
+    }
+  }
+
+  return t_tid;
+}
+
+
+void writeAtExit(void)
+{
+  trace::write();
+}
+
+
+std::string escape(const std::string & s)
+{
+  std::string out;
+  for (char c : s)
+  {
+    if ((c == '"') || (c == '\\')) out += '\\';
+    out += c;
+  }
+  return out;
+}
+
+}
+
+
+namespace trace {
+
+bool g_enabled = false;
+
+
+void init(const char *path)
+{
+  if ((path == nullptr) || (*path == '\0')) return;
+
+  if (!g_enabled) std::atexit(writeAtExit);
+
+  std::lock_guard<std::mutex> lock(g_mutex);
+  threadTid();    // vlakno, ktore zapina trasovanie, dostane prve tid
+
+  g_path = path;
+  g_events.reserve(1024);
+  g_origin = now();
+  g_enabled = true;
+}
+
+
+uint64_t now(void)
+{
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+void setDeviceClock(uint64_t device_ns, uint64_t host_ns)
+{
+  if (!g_enabled) return;
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_device_offset = int64_t(host_ns) - int64_t(device_ns);
+}
+
+
+void setThreadName(const std::string & name)
+{
+  if (!g_enabled) return;
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_thread_names[threadTid()] = name;
+}
+
+
+void hostSpan(const std::string & name, uint64_t begin_ns, uint64_t end_ns)
+{
+  if (!g_enabled) return;
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_events.push_back(Event { name, KindHost, threadTid(), 0, begin_ns, end_ns, 0, 0, 0, 0 });
+}
+
+
+void deviceSpan(const std::string & name, uint64_t queued, uint64_t submit, uint64_t start, uint64_t end)
+{
+  if (!g_enabled) return;
+  std::lock_guard<std::mutex> lock(g_mutex);
+
+  uint64_t q = uint64_t(int64_t(queued) + g_device_offset);
+  uint64_t s = uint64_t(int64_t(start)  + g_device_offset);
+  uint64_t e = uint64_t(int64_t(end)    + g_device_offset);
+
+  // cakanie vo fronte (queued -> start) a samotne vykonanie na zariadeni (start -> end)
+  uint64_t id = g_next_id++;
+  g_events.push_back(Event { name, KindQueued, 0,          id, q, s, queued, submit, start, end });
+  g_events.push_back(Event { name, KindDevice, TID_DEVICE, id, s, e, queued, submit, start, end });
+}
+
+
+bool write(void)
+{
+  if (!g_enabled) return true;
+
+  std::lock_guard<std::mutex> lock(g_mutex);
+
+  std::ofstream f(g_path.c_str());
+  if (!f)
+  {
+    std::cerr << "Failed to open trace file " << g_path << std::endl;
+    return false;
+  }
+
+  f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  f << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << TID_DEVICE << ",\"name\":\"thread_name\",\"args\":{\"name\":\"OpenCL device\"}}";
+  for (const auto & t : g_thread_names)
+  {
+    f << ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << t.first << ",\"name\":\"thread_name\",\"args\":{\"name\":\"" << escape(t.second) << "\"}}";
+  }
+
+  f.precision(3);
+  f << std::fixed;
+
+  for (const Event & e : g_events)
+  {
+    double ts  = (int64_t(e.begin) - int64_t(g_origin)) * 1e-3;   // Chrome trace pouziva mikrosekundy
+    double dur = (int64_t(e.end) - int64_t(e.begin)) * 1e-3;
+
+    if (e.kind == KindQueued)
+    {
+      // dvojica b/e s rovnakym id, kazdy cakajuci prikaz dostane vlastny riadok
+      f << ",\n{\"ph\":\"b\",\"cat\":\"OpenCL queued\",\"id\":" << e.id << ",\"pid\":1,\"tid\":" << TID_DEVICE
+        << ",\"name\":\"" << escape(e.name) << "\",\"ts\":" << ts
+        << ",\"args\":{\"queued\":" << e.queued << ",\"submit\":" << e.submit << "}}";
+      f << ",\n{\"ph\":\"e\",\"cat\":\"OpenCL queued\",\"id\":" << e.id << ",\"pid\":1,\"tid\":" << TID_DEVICE
+        << ",\"name\":\"" << escape(e.name) << "\",\"ts\":" << (ts + dur) << "}";
+      continue;
+    }
+
+    f << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+      << ",\"name\":\"" << escape(e.name) << "\""
+      << ",\"ts\":" << ts << ",\"dur\":" << dur;
+
+    if (e.kind == KindDevice)
+    {
+      f << ",\"args\":{\"queued\":" << e.queued << ",\"submit\":" << e.submit
+        << ",\"start\":" << e.start << ",\"end\":" << e.finish << "}";
+    }
+
+    f << "}";
+  }
+
+  f << "\n]}\n";
+
+  if (!f)
+  {
+    std::cerr << "Failed to write trace file " << g_path << std::endl;
+    return false;
+  }
+
+  std::cerr << "Trace with " << g_events.size() << " events written to " << g_path << std::endl;
+
+  return true;
+}
+
+} // End of trace namespace
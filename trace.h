@@ -0,0 +1,85 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Recording of host and OpenCL device spans, exported as Chrome trace JSON
+ * (viewable in chrome://tracing or Perfetto).
+ * Tracing is disabled unless init() is called, in which case every call
+ * costs only a check of a global flag.
+ * All timestamps are converted to the host steady clock, device timestamps
+ * are shifted by an offset measured by setDeviceClock().
+ */
+namespace trace {
+
+extern bool g_enabled;
+
+inline bool enabled(void) { return g_enabled; }
+
+/** Enables tracing, the trace is written to path when the program exits */
+void init(const char *path);
+
+/** Writes the recorded trace, returns false on failure */
+bool write(void);
+
+/** Current host time in nanoseconds (steady clock) */
+uint64_t now(void);
+
+/** Tells the tracer that device time device_ns corresponds to host time host_ns */
+void setDeviceClock(uint64_t device_ns, uint64_t host_ns);
+
+/** Names the calling thread in the trace, host spans of every thread are shown separately */
+void setThreadName(const std::string & name);
+
+/** Records a host span [begin_ns, end_ns) of the calling thread */
+void hostSpan(const std::string & name, uint64_t begin_ns, uint64_t end_ns);
+
+/**
+ * Records the OpenCL profiling timestamps (device clock) of one command.
+ * The execution (start -> end) is a slice of the device track, the wait in the queue
+ * (queued -> start) an async event of its own, as commands enqueued back to back overlap there.
+ */
+void deviceSpan(const std::string & name, uint64_t queued, uint64_t submit, uint64_t start, uint64_t end);
+
+
+/**
+ * Host span that lasts until next() or until it is destroyed.
+ * next() ends the current stage and starts the following one,
+ * so a function can be split into stages by a single line per stage.
+ */
+class Span
+{
+  public:
+    explicit Span(const char *name)
+      : m_name(name)
+      , m_begin(enabled() ? now() : 0)
+    { }
+
+    ~Span(void) { end(); }
+
+    Span(const Span &) = delete;
+    Span & operator=(const Span &) = delete;
+
+    void next(const char *name)
+    {
+      end();
+      m_name = name;
+      m_begin = enabled() ? now() : 0;
+    }
+
+    void end(void)
+    {
+      if ((m_name != nullptr) && enabled()) hostSpan(m_name, m_begin, now());
+      m_name = nullptr;
+    }
+
+  private:
+    const char *m_name;
+    uint64_t m_begin;
+};
+
+} // End of trace namespace
+
+#endif // TRACE_H
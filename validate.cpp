@@ -0,0 +1,131 @@
+#include "validate.h"
+#include "parallel.h"
+
+#include <ostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+
+
+namespace {
+
+/** Maps a float to an integer so that neighbouring floats map to neighbouring integers */
+int64_t orderedBits(float f)
+{
+  int32_t i;
+  std::memcpy(&i, &f, sizeof(i));
+  return (i < 0) ? (int64_t(INT32_MIN) - int64_t(i)) : int64_t(i);
+}
+
+
+uint32_t ulpDistance(float a, float b)
+{
+  int64_t d = orderedBits(a) - orderedBits(b);
+  if (d < 0) d = -d;
+  return (d > int64_t(UINT32_MAX)) ? UINT32_MAX : uint32_t(d);
+}
+
+
+/** Kahanova (kompenzovana) suma */
+struct KahanSum
+{
+  double sum = 0.0;
+  double c = 0.0;
+
+  void add(double x)
+  {
+    double y = x - c;
+    double t = sum + y;
+    c = (t - sum) - y;
+    sum = t;
+  }
+};
+
+}
+
+
+namespace validate {
+
+Report compare(const float *ref, const float *out, int w, int h, int n_threads)
+{
+  // kazde vlakno porovna svoj pas riadkov, vysledky sa na konci spoja
+  std::vector<Report> partial(std::max(1, (n_threads > 0) ? n_threads : int(std::thread::hardware_concurrency())));
+  std::vector<KahanSum> sums(partial.size());
+
+  int used = parallelFor(h, int(partial.size()), [&](int t, int j0, int j1) {
+    Report & r = partial[t];
+    KahanSum & sum = sums[t];
+    r.max_abs_err = -1.0;
+
+    for (int j = j0; j < j1; ++j)
+    {
+      for (int i = 0; i < w; ++i)
+      {
+        size_t idx = size_t(i) + size_t(j) * w;
+        float a = ref[idx];
+        float b = out[idx];
+
+        double err;
+        uint32_t ulp;
+
+        if (std::isnan(a) || std::isnan(b))
+        {
+          bool both = std::isnan(a) && std::isnan(b);
+          err = both ? 0.0 : std::numeric_limits<double>::infinity();
+          ulp = both ? 0 : UINT32_MAX;
+        }
+        else
+        {
+          err = std::fabs(double(a) - double(b));
+          ulp = ulpDistance(a, b);
+        }
+
+        sum.add(err);
+        if (ulp > r.max_ulp_err) r.max_ulp_err = ulp;
+
+        if (err > r.max_abs_err)
+        {
+          r.max_abs_err = err;
+          r.worst_x = i;
+          r.worst_y = j;
+          r.worst_ref = a;
+          r.worst_out = b;
+        }
+      }
+    }
+  });
+
+  Report res;
+  KahanSum total;
+  res.max_abs_err = -1.0;
+
+  for (int t = 0; t < used; ++t)
+  {
+    total.add(sums[t].sum);
+    if (partial[t].max_ulp_err > res.max_ulp_err) res.max_ulp_err = partial[t].max_ulp_err;
+    if (partial[t].max_abs_err > res.max_abs_err)
+    {
+      uint32_t ulp = res.max_ulp_err;
+      res = partial[t];
+      res.max_ulp_err = ulp;
+    }
+  }
+
+  if (res.max_abs_err < 0.0) res.max_abs_err = 0.0;
+  res.mean_abs_err = ((w > 0) && (h > 0)) ? (total.sum / (double(w) * double(h))) : 0.0;
+
+  return res;
+}
+
+
+std::ostream & operator<<(std::ostream & os, const Report & r)
+{
+  os << "Average difference between elements of arrays: " << r.mean_abs_err << std::endl
+     << "Max absolute error: " << r.max_abs_err << " at (" << r.worst_x << ", " << r.worst_y << ")"
+     << " [reference " << r.worst_ref << ", result " << r.worst_out << "], max ULP error: " << r.max_ulp_err;
+  return os;
+}
+
+} // End of validate namespace
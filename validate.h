@@ -0,0 +1,31 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <cstdint>
+#include <iosfwd>
+
+namespace validate {
+
+/** Result of comparison of an output image with the reference */
+struct Report
+{
+  double mean_abs_err = 0.0;    // priemerna absolutna chyba (Kahanova suma v double)
+  double max_abs_err = 0.0;
+  uint32_t max_ulp_err = 0;     // najvacsia vzdialenost v ULP (pocet reprezentovatelnych floatov medzi hodnotami)
+  int worst_x = 0;              // pixel s najvacsou absolutnou chybou
+  int worst_y = 0;
+  float worst_ref = 0.0f;
+  float worst_out = 0.0f;
+};
+
+/**
+ * Compares w x h images ref and out on n_threads threads (0 = all hardware threads).
+ * NaN in only one of the images counts as infinite error.
+ */
+Report compare(const float *ref, const float *out, int w, int h, int n_threads = 0);
+
+std::ostream & operator<<(std::ostream & os, const Report & r);
+
+} // End of validate namespace
+
+#endif // VALIDATE_H